@@ -0,0 +1,32 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.cpp
+//
+// Identification: src/buffer/buffer_access_strategy.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_access_strategy.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+BufferAccessStrategy::Slot *BufferAccessStrategy::NextSlot(uint32_t instance_index, uint32_t num_instances) {
+  if (rings_.size() < num_instances) {
+    rings_.resize(num_instances);
+  }
+  Ring &ring = rings_[instance_index];
+  if (ring.slots_.empty()) {
+    ring.slots_.resize(std::max<size_t>(1, ring_size_ / num_instances));
+  }
+  Slot *slot = &ring.slots_[ring.next_];
+  ring.next_ = (ring.next_ + 1) % ring.slots_.size();
+  return slot;
+}
+
+}  // namespace bustub
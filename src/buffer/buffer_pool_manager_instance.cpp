@@ -12,64 +12,172 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include <../include/common/logger.h>
+#include <algorithm>
+#include <future>  // NOLINT
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
 #include "common/macros.h"
 
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
-    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager) {}
+                                                     LogManager *log_manager, ReplacerPolicy replacer_policy,
+                                                     HugePageMode huge_page_mode, bool prefault, size_t max_pool_size,
+                                                     size_t compressed_cache_size)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, log_manager, replacer_policy, huge_page_mode, prefault,
+                                max_pool_size, compressed_cache_size) {}
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                                                     DiskManager *disk_manager, LogManager *log_manager)
+                                                     DiskManager *disk_manager, LogManager *log_manager,
+                                                     ReplacerPolicy replacer_policy, HugePageMode huge_page_mode,
+                                                     bool prefault, size_t max_pool_size, size_t compressed_cache_size)
     : pool_size_(pool_size),
+      max_pool_size_(std::max(pool_size, max_pool_size)),
+      prefault_(prefault),
       num_instances_(num_instances),
       instance_index_(instance_index),
       next_page_id_(instance_index),
+      // Frames past pool_size only take up address space until the pool grows into them.
+      frame_arena_(max_pool_size_, huge_page_mode, false),
       disk_manager_(disk_manager),
-      log_manager_(log_manager) {
+      log_manager_(log_manager),
+      free_list_(max_pool_size_) {
   BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
   BUSTUB_ASSERT(
       instance_index < num_instances,
       "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 1.");
-  // We allocate a consecutive memory space for the buffer pool.
-  pages_ = new Page[pool_size_];
-  replacer_ = new LRUReplacer(pool_size);
-
-  // Initially, every page is in the free list.
-  for (size_t i = 0; i < pool_size_; ++i) {
-    free_list_.emplace_back(static_cast<int>(i));
+  if (prefault_) {
+    frame_arena_.Prefault(0, pool_size);
+  }
+  // We allocate a consecutive memory space for the buffer pool. The page objects only hold the metadata, their data
+  // is in the arena.
+  pages_ = static_cast<Page *>(::operator new[](max_pool_size_ * sizeof(Page)));
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    new (pages_ + i) Page(frame_arena_.GetFrameData(i));
+  }
+  frame_latches_ = new std::mutex[max_pool_size_];
+  frame_io_cvs_ = new std::condition_variable[max_pool_size_];
+  switch (replacer_policy) {
+    case ReplacerPolicy::LRU_K:
+      replacer_ = new LRUKReplacer(max_pool_size_, LRU_K);
+      break;
+    case ReplacerPolicy::CLOCK:
+      replacer_ = new ClockReplacer(max_pool_size_);
+      break;
+    case ReplacerPolicy::LRU:
+    default:
+      replacer_ = new LRUReplacer(max_pool_size_);
+      break;
+  }
+  if (compressed_cache_size > 0) {
+    compressed_cache_ = new CompressedPageCache(compressed_cache_size);
+  }
+  // Initially, every frame in use is in the free list, with frame 0 on top.
+  frame_id_t frame_id;
+  while (free_list_.Pop(&frame_id)) {
+  }
+  for (size_t i = pool_size; i > 0; i--) {
+    free_list_.Push(static_cast<frame_id_t>(i - 1));
   }
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  StopPrefetcher();
+  StopPageCleaner();
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    pages_[i].~Page();
+  }
+  ::operator delete[](pages_);
+  delete[] frame_latches_;
+  delete[] frame_io_cvs_;
   delete replacer_;
+  delete compressed_cache_;
 }
 
 bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
   // Make sure you call DiskManager::WritePage!
-  // frame_id_t frame_id = page_table_
-  std::lock_guard<std::mutex> guard(latch_);
-  auto pit = page_table_.find(page_id);
-  if (pit == page_table_.end()) {
+  auto &stripe = GetStripe(page_id);
+  std::unique_lock<std::mutex> stripe_guard(stripe.latch_);
+  auto pit = stripe.table_.find(page_id);
+  if (pit == stripe.table_.end()) {
     // LOG_WARN("not find page_id %d in page_table", page_id);
     return false;
   }
-  if (pages_[pit->second].is_dirty_) {
-    disk_manager_->WritePage(page_id, pages_[pit->second].GetData());
-    pages_[pit->second].is_dirty_ = false;
+  frame_id_t frame_id = pit->second;
+  std::unique_lock<std::mutex> frame_guard(frame_latches_[frame_id]);
+  stripe_guard.unlock();
+  frame_io_cvs_[frame_id].wait(frame_guard, [&] { return !pages_[frame_id].io_in_progress_; });
+  // The page cleaner may have an older copy on its way to disk. No new one can start while we hold the frame latch.
+  WaitForWritebacks(page_id, 0);
+  // A caller may fill a new page and flush it without marking it dirty, so a new page is written even if clean.
+  if (pages_[frame_id].is_dirty_ || pages_[frame_id].is_new_) {
+    disk_manager_->WritePage(page_id, pages_[frame_id].GetData());
+    pages_[frame_id].is_dirty_ = false;
+    pages_[frame_id].is_new_ = false;
   }
   return true;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  // You can do it!
-  std::lock_guard<std::mutex> guard(latch_);
-  for (auto pageit : page_table_) {
-    if (pages_[pageit.second].is_dirty_) {
-      disk_manager_->WritePage(pageit.first, pages_[pageit.second].GetData());
-      pages_[pageit.second].is_dirty_ = false;
+  WriteBackAllPages();
+  disk_manager_->SyncData();
+}
+
+void BufferPoolManagerInstance::WriteBackAllPages() {
+  // Collect the dirty pages and sort them by page id, so that the writes sweep the file once.
+  std::vector<std::pair<page_id_t, frame_id_t>> dirty_pages;
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    std::lock_guard<std::mutex> frame_guard(frame_latches_[i]);
+    if (pages_[i].page_id_ != INVALID_PAGE_ID && pages_[i].is_dirty_) {
+      dirty_pages.emplace_back(pages_[i].page_id_, static_cast<frame_id_t>(i));
+    }
+  }
+  std::sort(dirty_pages.begin(), dirty_pages.end());
+
+  // Aligned, so that a disk manager doing direct I/O writes the copies as they are.
+  AlignedPageBuffer buffer(std::min(dirty_pages.size(), FLUSH_BATCH_PAGES));
+  std::vector<page_id_t> page_ids;
+  std::vector<const char *> page_data;
+  for (size_t first = 0; first < dirty_pages.size(); first += FLUSH_BATCH_PAGES) {
+    // Copy the pages out like the page cleaner does. A page may have been evicted, or written back, since we looked.
+    page_ids.clear();
+    page_data.clear();
+    for (size_t i = first; i < std::min(first + FLUSH_BATCH_PAGES, dirty_pages.size()); i++) {
+      auto [page_id, frame_id] = dirty_pages[i];
+      Page *page = pages_ + frame_id;
+      std::lock_guard<std::mutex> frame_guard(frame_latches_[frame_id]);
+      if (page->page_id_ != page_id || !page->is_dirty_ || page->io_in_progress_) {
+        continue;
+      }
+      // An older copy may still be on its way to disk, from the page cleaner or an eviction. Ours has to land after
+      // it. No new one can start while we hold the frame latch.
+      WaitForWritebacks(page_id, 0);
+      char *copy = buffer.GetPage(page_ids.size());
+      memcpy(copy, page->GetData(), PAGE_SIZE);
+      page->is_dirty_ = false;
+      page->is_new_ = false;
+      StartWriteback(page_id);
+      page_ids.push_back(page_id);
+      page_data.push_back(copy);
+    }
+    // Start all the runs of the batch before waiting for any, so the disk sees them at once.
+    std::vector<std::future<void>> writes;
+    for (size_t run = 0; run < page_ids.size();) {
+      size_t end = run + 1;
+      while (end < page_ids.size() && page_ids[end] == page_ids[end - 1] + 1) {
+        end++;
+      }
+      writes.push_back(disk_manager_->WritePagesAsync(page_ids[run], page_data.data() + run, end - run));
+      run = end;
+    }
+    for (auto &write : writes) {
+      write.wait();
+    }
+    for (page_id_t page_id : page_ids) {
+      FinishWriteback(page_id);
     }
   }
 }
@@ -80,65 +188,524 @@ Page *BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) {
   // 2.   Pick a victim page P from either the free list or the replacer. Always pick from the free list first.
   // 3.   Update P's metadata, zero out memory and add P to the page table.
   // 4.   Set the page ID output parameter. Return a pointer to P.
-  std::lock_guard<std::mutex> guard(latch_);
-  bool is_allpin = true;
-  for (size_t i = 0; i < pool_size_; i++) {
-    if (pages_[i].GetPinCount() == 0) {
-      is_allpin = false;
-      break;
-    }
+  return CreatePage(page_id, true);
+}
+
+Page *BufferPoolManagerInstance::NewPgExtentImp(page_id_t *page_id, ExtentAllocator *extent) {
+  if (num_instances_ > 1) {
+    return NewPgImp(page_id);
   }
-  if (is_allpin) {
+  const page_id_t new_page_id = extent->Allocate(disk_manager_);
+  Page *page = NewPageAt(new_page_id);
+  if (page == nullptr) {
+    extent->Return(new_page_id);
     return nullptr;
   }
+  *page_id = new_page_id;
+  return page;
+}
+
+Page *BufferPoolManagerInstance::NewPageAt(page_id_t page_id) {
+  ValidatePageId(page_id);
+  return CreatePage(&page_id, false);
+}
+
+Page *BufferPoolManagerInstance::CreatePage(page_id_t *page_id, bool allocate) {
+  // Step 1 needs no scan: with no free frame and nothing in the replacer, every frame is pinned.
+  if (free_list_.Size() == 0 && replacer_->Size() == 0) {
+    counters_.pin_failures_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  auto guard = LockLatch();
   frame_id_t rframe_id;
-  if (!FindFreePage(&rframe_id)) {
+  if (!allocate && PinFrame(*page_id, &rframe_id, true)) {
+    // A read-ahead went past the end of its table heap and read the page before it was created. Take its frame over.
+    guard.unlock();
+    WaitForIo(rframe_id);
+    Page *page = pages_ + rframe_id;
+    page->WLatch();
+    page->ResetMemory();
+    page->WUnlatch();
+    std::lock_guard<std::mutex> frame_guard(frame_latches_[rframe_id]);
+    page->is_new_ = true;
+    return page;
+  }
+  if (allocate) {
+    *page_id = AllocatePage();
+    if (*page_id == INVALID_PAGE_ID) {
+      return nullptr;
+    }
+  }
+  Victim victim;
+  if (!FindFreePage(&rframe_id, &victim)) {
     // LOG_WARN("return nullptr");
+    if (allocate) {
+      // Hand the id out again next time.
+      DeallocatePage(*page_id);
+    }
+    counters_.pin_failures_.fetch_add(1, std::memory_order_relaxed);
     return nullptr;
   }
-  *page_id = AllocatePage();
-  ResetPage(rframe_id);
-  pages_[rframe_id].page_id_ = *page_id;
-  pages_[rframe_id].pin_count_ = 1;
-  replacer_->Pin(rframe_id);
-  // add to table
-  page_table_.insert(std::make_pair(*page_id, rframe_id));
+  PublishFrame(rframe_id, *page_id, true, true);
+  guard.unlock();
+  LoadFrame(rframe_id, *page_id, victim, false);
   // LOG_DEBUG("page_id %d has add to table", *page_id);
   return pages_ + rframe_id;
 }
 
-void BufferPoolManagerInstance::ResetPage(const frame_id_t &frame_id) {
-  // LOG_DEBUG("the frame_id is %d", frame_id);
-  pages_[frame_id].page_id_ = INVALID_PAGE_ID;
-  pages_[frame_id].pin_count_ = 0;
+bool BufferPoolManagerInstance::FindFreePage(frame_id_t *frame_id, Victim *victim) {
+  // LOG_DEBUG("...");
+  *victim = Victim();
+  if (free_list_.Pop(frame_id)) {
+    return true;
+  }
+  while (replacer_->Victim(frame_id)) {
+    if (static_cast<size_t>(*frame_id) >= pool_size_) {
+      // Resize is retiring this frame. Leave the page where it is, out of the replacer, for Resize to evict.
+      continue;
+    }
+    if (EvictFrame(*frame_id, victim)) {
+      if (victim->page_id_ != INVALID_PAGE_ID) {
+        StartWriteback(victim->page_id_);
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+bool BufferPoolManagerInstance::FindRingFrame(const BufferAccessStrategy::Slot &slot, frame_id_t *frame_id,
+                                              Victim *victim) {
+  // page_id_ only changes under latch_. If the frame holds another page now, the ring lost it to a regular eviction.
+  if (slot.frame_id_ >= 0 && static_cast<size_t>(slot.frame_id_) < pool_size_ &&
+      pages_[slot.frame_id_].page_id_ == slot.page_id_ && EvictFrame(slot.frame_id_, victim)) {
+    *frame_id = slot.frame_id_;
+    if (victim->page_id_ != INVALID_PAGE_ID) {
+      StartWriteback(victim->page_id_);
+    }
+    return true;
+  }
+  return FindFreePage(frame_id, victim);
+}
+
+bool BufferPoolManagerInstance::EvictFrame(frame_id_t frame_id, Victim *victim) {
+  Page *page = pages_ + frame_id;
+  // page_id_ only changes under latch_, which we hold, so it is safe to read before taking the frame latch.
+  page_id_t rpg_id = page->page_id_;
+  auto &stripe = GetStripe(rpg_id);
+  std::lock_guard<std::mutex> stripe_guard(stripe.latch_);
+  std::lock_guard<std::mutex> frame_guard(frame_latches_[frame_id]);
+  if (page->pin_count_ > 0) {
+    // A hit pinned the frame after the replacer picked it. Unpin will hand it back to the replacer.
+    return false;
+  }
+  // A hit may have pinned and unpinned the frame after it was picked, which puts it back into the replacer.
+  replacer_->Remove(frame_id);
+  stripe.table_.erase(rpg_id);
+  // With a compressed cache, clean victims are retired too, and a miss on them waits until they are in the cache.
+  *victim = Victim();
+  if (page->is_dirty_ || compressed_cache_ != nullptr) {
+    victim->page_id_ = rpg_id;
+    victim->dirty_ = page->is_dirty_;
+  }
+  page->page_id_ = INVALID_PAGE_ID;
+  page->is_dirty_ = false;
+  counters_.evictions_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void BufferPoolManagerInstance::PublishFrame(frame_id_t frame_id, page_id_t page_id, bool record_access, bool is_new) {
+  auto &stripe = GetStripe(page_id);
+  std::lock_guard<std::mutex> stripe_guard(stripe.latch_);
+  std::lock_guard<std::mutex> frame_guard(frame_latches_[frame_id]);
+  pages_[frame_id].page_id_ = page_id;
+  pages_[frame_id].pin_count_ = 1;
   pages_[frame_id].is_dirty_ = false;
-  pages_[frame_id].ResetMemory();
+  pages_[frame_id].is_new_ = is_new;
+  pages_[frame_id].io_in_progress_ = true;
+  num_pinned_frames_++;
+  if (record_access) {
+    replacer_->RecordAccess(frame_id);
+  }
+  stripe.table_.insert(std::make_pair(page_id, frame_id));
 }
 
-bool BufferPoolManagerInstance::FindFreePage(frame_id_t *frame_id) {
-  // LOG_DEBUG("...");
-  if (free_list_.empty()) {
-    if (auto vicok = replacer_->Victim(frame_id); !vicok) {
-      return false;
+void BufferPoolManagerInstance::LoadFrame(frame_id_t frame_id, page_id_t page_id, const Victim &victim,
+                                          bool read_from_disk) {
+  Page *page = pages_ + frame_id;
+  RetireVictim(frame_id, victim);
+  if (read_from_disk && ServeFromMapping(frame_id, page_id)) {
+    FinishLoad(frame_id);
+    return;
+  }
+  // Reads past the end of the file leave the buffer untouched, so clear the victim's data first either way.
+  page->ResetMemory();
+  if (read_from_disk && !ReadFromCompressedCache(page_id, page->GetData())) {
+    disk_manager_->ReadPage(page_id, page->GetData());
+  }
+  FinishLoad(frame_id);
+}
+
+bool BufferPoolManagerInstance::ServeFromMapping(frame_id_t frame_id, page_id_t page_id) {
+  Page *page = pages_ + frame_id;
+  const char *mapped = disk_manager_->GetMappedPage(page_id);
+  if (mapped == nullptr) {
+    return false;
+  }
+  // Page::WLatch copies the page into the frame before anyone modifies it, so the cast is never written through.
+  page->data_ = const_cast<char *>(mapped);
+  counters_.mapped_reads_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void BufferPoolManagerInstance::RetireVictim(frame_id_t frame_id, const Victim &victim) {
+  // The frame still holds the victim's data; it is only overwritten once the victim is safely on disk.
+  if (victim.page_id_ != INVALID_PAGE_ID) {
+    if (victim.dirty_) {
+      // The page cleaner may still be writing an older copy of the victim. Ours has to land after it.
+      WaitForWritebacks(victim.page_id_, 1);
+      disk_manager_->WritePage(victim.page_id_, pages_[frame_id].GetData());
+      foreground_writebacks_++;
     }
-    page_id_t rpg_id = pages_[*frame_id].GetPageId();
-    if (pages_[*frame_id].IsDirty()) {
-      disk_manager_->WritePage(rpg_id, pages_[*frame_id].GetData());
-      pages_[*frame_id].is_dirty_ = false;
+    // The cached copy has to match the disk, so it goes in after the write, but before a miss can read the page again.
+    // A page served from the mapping is served from there again.
+    if (compressed_cache_ != nullptr && pages_[frame_id].data_ == pages_[frame_id].frame_data_) {
+      compressed_cache_->Insert(victim.page_id_, pages_[frame_id].GetData());
     }
-    page_table_.erase(rpg_id);
-  } else {
-    *frame_id = free_list_.front();
-    free_list_.pop_front();
+    FinishWriteback(victim.page_id_);
+  }
+  // The frame may point at a page in the read-only mapping of the db file. The next page goes into the frame itself.
+  pages_[frame_id].data_ = pages_[frame_id].frame_data_;
+}
+
+bool BufferPoolManagerInstance::ReadFromCompressedCache(page_id_t page_id, char *page_data) {
+  if (compressed_cache_ == nullptr || !compressed_cache_->Get(page_id, page_data)) {
+    return false;
+  }
+  counters_.compressed_cache_hits_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void BufferPoolManagerInstance::FinishLoad(frame_id_t frame_id) {
+  {
+    std::lock_guard<std::mutex> frame_guard(frame_latches_[frame_id]);
+    pages_[frame_id].io_in_progress_ = false;
+  }
+  frame_io_cvs_[frame_id].notify_all();
+}
+
+bool BufferPoolManagerInstance::HasWriteback(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(writeback_latch_);
+  return writeback_pages_.find(page_id) != writeback_pages_.end();
+}
+
+void BufferPoolManagerInstance::StartWriteback(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(writeback_latch_);
+  writeback_pages_[page_id]++;
+}
+
+void BufferPoolManagerInstance::WaitForWritebacks(page_id_t page_id, size_t num_own) {
+  std::unique_lock<std::mutex> guard(writeback_latch_);
+  writeback_cv_.wait(guard, [&] {
+    auto it = writeback_pages_.find(page_id);
+    return it == writeback_pages_.end() || it->second <= num_own;
+  });
+}
+
+void BufferPoolManagerInstance::FinishWriteback(page_id_t page_id) {
+  {
+    std::lock_guard<std::mutex> guard(writeback_latch_);
+    auto it = writeback_pages_.find(page_id);
+    if (--it->second == 0) {
+      writeback_pages_.erase(it);
+    }
+  }
+  writeback_cv_.notify_all();
+}
+
+void BufferPoolManagerInstance::PrefetchPgImp(page_id_t page_id) {
+  if (HavePage(page_id)) {
+    return;
+  }
+  // A mapped page is served without a read, so loading it early saves nothing. Have the kernel read it in instead.
+  if (disk_manager_->GetMappedPage(page_id) != nullptr) {
+    disk_manager_->AdviseWillNeed(page_id, 1);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(prefetch_latch_);
+    if (prefetch_queue_.size() >= pool_size_) {
+      return;
+    }
+    if (prefetch_thread_ == nullptr) {
+      prefetch_running_ = true;
+      prefetch_thread_ = new std::thread(&BufferPoolManagerInstance::RunPrefetcher, this);
+    }
+    prefetch_queue_.push_back(page_id);
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManagerInstance::StopPrefetcher() {
+  std::thread *prefetch_thread;
+  {
+    std::lock_guard<std::mutex> guard(prefetch_latch_);
+    prefetch_thread = prefetch_thread_;
+    prefetch_thread_ = nullptr;
+    prefetch_running_ = false;
+    prefetch_queue_.clear();
+  }
+  if (prefetch_thread == nullptr) {
+    return;
+  }
+  prefetch_cv_.notify_all();
+  prefetch_thread->join();
+  delete prefetch_thread;
+}
+
+void BufferPoolManagerInstance::RunPrefetcher() {
+  std::unique_lock<std::mutex> guard(prefetch_latch_);
+  while (true) {
+    prefetch_cv_.wait(guard, [&] { return !prefetch_running_ || !prefetch_queue_.empty(); });
+    if (!prefetch_running_) {
+      return;
+    }
+    // Take what is queued, up to a batch, so that the reads are in flight together. The batch stays pinned until its
+    // reads are done, so it takes at most half of the unpinned frames, to leave the rest to foreground fetches.
+    size_t unpinned = pool_size_ - std::min<size_t>(pool_size_, num_pinned_frames_);
+    size_t batch_size = std::max<size_t>(1, std::min(PREFETCH_BATCH_PAGES, unpinned / 2));
+    std::vector<page_id_t> page_ids;
+    while (!prefetch_queue_.empty() && page_ids.size() < batch_size) {
+      page_ids.push_back(prefetch_queue_.front());
+      prefetch_queue_.pop_front();
+    }
+    guard.unlock();
+    // Skip pages that became resident since they were queued. The rest are regular misses, except that they do not
+    // count as accesses. Unpinning right away leaves the pages to the replacer.
+    auto resident = [&](page_id_t page_id) { return HavePage(page_id); };
+    page_ids.erase(std::remove_if(page_ids.begin(), page_ids.end(), resident), page_ids.end());
+    std::vector<Page *> pages(page_ids.size());
+    FetchFrames(page_ids.data(), page_ids.size(), pages.data(), false);
+    for (Page *page : pages) {
+      if (page != nullptr) {
+        UnpinFrameImp(page, false);
+      }
+    }
+    guard.lock();
+  }
+}
+
+void BufferPoolManagerInstance::StartPageCleaner(double target_clean_ratio, size_t max_writes_per_second) {
+  std::lock_guard<std::mutex> guard(cleaner_latch_);
+  if (cleaner_thread_ != nullptr) {
+    return;
+  }
+  cleaner_target_clean_ratio_ = target_clean_ratio;
+  cleaner_max_writes_per_second_ = max_writes_per_second;
+  cleaner_running_ = true;
+  cleaner_thread_ = new std::thread(&BufferPoolManagerInstance::RunPageCleaner, this);
+}
+
+void BufferPoolManagerInstance::StopPageCleaner() {
+  std::thread *cleaner_thread;
+  {
+    std::lock_guard<std::mutex> guard(cleaner_latch_);
+    cleaner_thread = cleaner_thread_;
+    cleaner_thread_ = nullptr;
+    cleaner_running_ = false;
+  }
+  if (cleaner_thread == nullptr) {
+    return;
+  }
+  cleaner_cv_.notify_all();
+  cleaner_thread->join();
+  delete cleaner_thread;
+}
+
+void BufferPoolManagerInstance::RunPageCleaner() {
+  // Write credits accumulate every round so that low rates still get to write once in a while.
+  const double credits_per_round =
+      static_cast<double>(cleaner_max_writes_per_second_) * PAGE_CLEANER_INTERVAL.count() / 1000;
+  double credits = 0;
+  std::unique_lock<std::mutex> guard(cleaner_latch_);
+  while (!cleaner_cv_.wait_for(guard, PAGE_CLEANER_INTERVAL, [&] { return !cleaner_running_; })) {
+    guard.unlock();
+    // Do not bank more than one round's worth of writes while there was nothing to clean.
+    credits = std::min(credits + credits_per_round, std::max(credits_per_round, 1.0));
+    credits -= CleanVictims(static_cast<size_t>(credits));
+    guard.lock();
+  }
+}
+
+size_t BufferPoolManagerInstance::CleanVictims(size_t max_writes) {
+  if (max_writes == 0) {
+    return 0;
+  }
+  std::vector<frame_id_t> victims;
+  auto window = std::max<size_t>(1, static_cast<size_t>(cleaner_target_clean_ratio_ * pool_size_));
+  replacer_->PeekVictims(&victims, window);
+
+  // Copy the dirty pages out and register them in writeback_pages_, so that later writes of the same page and misses on
+  // it are ordered after ours. Unpinned pages cannot be modified, so the copies are consistent.
+  std::vector<page_id_t> page_ids;
+  AlignedPageBuffer buffer(std::min(max_writes, victims.size()));
+  for (frame_id_t frame_id : victims) {
+    if (page_ids.size() == max_writes) {
+      break;
+    }
+    Page *page = pages_ + frame_id;
+    std::lock_guard<std::mutex> frame_guard(frame_latches_[frame_id]);
+    if (page->page_id_ == INVALID_PAGE_ID || page->pin_count_ > 0 || !page->is_dirty_ || page->io_in_progress_) {
+      continue;
+    }
+    memcpy(buffer.GetPage(page_ids.size()), page->GetData(), PAGE_SIZE);
+    page->is_dirty_ = false;
+    page->is_new_ = false;
+    StartWriteback(page->page_id_);
+    page_ids.push_back(page->page_id_);
+  }
+  // Start all the writes before waiting for any, so the disk sees them at once.
+  std::vector<std::future<void>> writes;
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    const char *page_data = buffer.GetPage(i);
+    writes.push_back(disk_manager_->WritePagesAsync(page_ids[i], &page_data, 1));
+  }
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    writes[i].wait();
+    background_writebacks_++;
+    FinishWriteback(page_ids[i]);
+  }
+  return page_ids.size();
+}
+
+BufferPoolMetrics BufferPoolManagerInstance::GetMetrics() {
+  BufferPoolMetrics metrics;
+  metrics.fetches_ = counters_.fetches_.load(std::memory_order_relaxed);
+  metrics.hits_ = counters_.hits_.load(std::memory_order_relaxed);
+  metrics.misses_ = counters_.misses_.load(std::memory_order_relaxed);
+  metrics.evictions_ = counters_.evictions_.load(std::memory_order_relaxed);
+  metrics.foreground_writebacks_ = foreground_writebacks_;
+  metrics.background_writebacks_ = background_writebacks_;
+  metrics.pin_failures_ = counters_.pin_failures_.load(std::memory_order_relaxed);
+  metrics.latch_wait_ns_ = counters_.latch_wait_ns_.load(std::memory_order_relaxed);
+  metrics.compressed_cache_hits_ = counters_.compressed_cache_hits_.load(std::memory_order_relaxed);
+  metrics.mapped_reads_ = counters_.mapped_reads_.load(std::memory_order_relaxed);
+  return metrics;
+}
+
+std::unique_lock<std::mutex> BufferPoolManagerInstance::LockLatch() {
+  // Only time the lock when it is contended, so the uncontended case costs no clock reads.
+  std::unique_lock<std::mutex> guard(latch_, std::try_to_lock);
+  if (!guard.owns_lock()) {
+    auto start = std::chrono::steady_clock::now();
+    guard.lock();
+    auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    counters_.latch_wait_ns_.fetch_add(waited.count(), std::memory_order_relaxed);
+  }
+  return guard;
+}
+
+bool BufferPoolManagerInstance::Resize(size_t pool_size) {
+  if (pool_size == 0 || pool_size > max_pool_size_) {
+    return false;
+  }
+  std::lock_guard<std::mutex> resize_guard(resize_latch_);
+  auto guard = LockLatch();
+  size_t old_pool_size = pool_size_;
+  if (pool_size >= old_pool_size) {
+    if (prefault_) {
+      frame_arena_.Prefault(old_pool_size, pool_size - old_pool_size);
+    }
+    for (size_t i = old_pool_size; i < pool_size; i++) {
+      free_list_.Push(static_cast<frame_id_t>(i));
+    }
+    pool_size_ = pool_size;
+    return true;
+  }
+
+  // From here on, FindFreePage does not hand out the retired frames. Free ones just have to leave the free list. The
+  // free list is only popped and pushed under latch_, so it can be drained and refilled.
+  pool_size_ = pool_size;
+  std::vector<frame_id_t> free_frames;
+  frame_id_t frame_id;
+  while (free_list_.Pop(&frame_id)) {
+    if (static_cast<size_t>(frame_id) < pool_size) {
+      free_frames.push_back(frame_id);
+    }
+  }
+  for (auto it = free_frames.rbegin(); it != free_frames.rend(); ++it) {
+    free_list_.Push(*it);
+  }
+
+  // Evict the pages of the retired frames. Pages that are pinned are retried until they are unpinned.
+  std::vector<frame_id_t> retiring;
+  for (size_t i = pool_size; i < old_pool_size; i++) {
+    retiring.push_back(static_cast<frame_id_t>(i));
+  }
+  while (true) {
+    std::vector<frame_id_t> pinned;
+    std::vector<std::pair<frame_id_t, Victim>> victims;
+    for (frame_id_t retired : retiring) {
+      // page_id_ only changes under latch_, and so does the page table.
+      if (pages_[retired].page_id_ == INVALID_PAGE_ID) {
+        continue;
+      }
+      Victim victim;
+      if (!EvictFrame(retired, &victim)) {
+        pinned.push_back(retired);
+      } else if (victim.page_id_ != INVALID_PAGE_ID) {
+        StartWriteback(victim.page_id_);
+        victims.emplace_back(retired, victim);
+      }
+    }
+    guard.unlock();
+    // The retired frames are unreachable now, so their data can be retired without latches, like LoadFrame does.
+    for (auto &[retired, victim] : victims) {
+      RetireVictim(retired, victim);
+    }
+    if (pinned.empty()) {
+      break;
+    }
+    retiring = std::move(pinned);
+    std::this_thread::sleep_for(RESIZE_RETRY_INTERVAL);
+    guard.lock();
+  }
+  frame_arena_.Release(pool_size, old_pool_size - pool_size);
+  return true;
+}
+
+void BufferPoolManagerInstance::WaitForIo(frame_id_t frame_id) {
+  if (!pages_[frame_id].io_in_progress_) {
+    return;
+  }
+  std::unique_lock<std::mutex> frame_guard(frame_latches_[frame_id]);
+  frame_io_cvs_[frame_id].wait(frame_guard, [&] { return !pages_[frame_id].io_in_progress_; });
+}
+
+bool BufferPoolManagerInstance::PinFrame(page_id_t page_id, frame_id_t *frame_id, bool record_access) {
+  auto &stripe = GetStripe(page_id);
+  std::unique_lock<std::mutex> stripe_guard(stripe.latch_);
+  auto pageit = stripe.table_.find(page_id);
+  if (pageit == stripe.table_.end()) {
+    return false;
+  }
+  *frame_id = pageit->second;
+  std::lock_guard<std::mutex> frame_guard(frame_latches_[*frame_id]);
+  stripe_guard.unlock();
+  if (pages_[*frame_id].pin_count_++ == 0) {
+    replacer_->Pin(*frame_id);
+    num_pinned_frames_++;
+  }
+  if (record_access) {
+    replacer_->RecordAccess(*frame_id);
   }
   return true;
 }
 
 bool BufferPoolManagerInstance::HavePage(page_id_t page_id) {
-  std::lock_guard<std::mutex> guard(latch_);
-  auto pit = page_table_.find(page_id);
-  bool have = (pit != page_table_.end());
-  return have;
+  auto &stripe = GetStripe(page_id);
+  std::lock_guard<std::mutex> guard(stripe.latch_);
+  return stripe.table_.find(page_id) != stripe.table_.end();
 }
 
 Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
@@ -149,81 +716,316 @@ Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
   // 2.     If R is dirty, write it back to the disk.
   // 3.     Delete R from the page table and insert P.
   // 4.     Update P's metadata, read in the page content from disk, and then return a pointer to P.
-  std::lock_guard<std::mutex> guard(latch_);
+  return FetchFrame(page_id, true);
+}
+
+Page *BufferPoolManagerInstance::FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  return FetchFrame(page_id, false, strategy);
+}
+
+Page *BufferPoolManagerInstance::FetchFrame(page_id_t page_id, bool record_access, BufferAccessStrategy *strategy) {
+  // Only fetches on behalf of callers are counted, not prefetches.
+  const bool counted = record_access || strategy != nullptr;
+  if (counted) {
+    counters_.fetches_.fetch_add(1, std::memory_order_relaxed);
+  }
   frame_id_t r_fid;
-  auto pageit = page_table_.find(page_id);
-  if (pageit != page_table_.end()) {
-    frame_id_t f_id = pageit->second;
-    pages_[f_id].pin_count_++;
-    if (pages_[f_id].pin_count_ == 1) {
-      replacer_->Pin(f_id);
+  if (PinFrame(page_id, &r_fid, record_access)) {
+    if (counted) {
+      counters_.hits_.fetch_add(1, std::memory_order_relaxed);
     }
-    return pages_ + f_id;
+    WaitForIo(r_fid);
+    return pages_ + r_fid;
   }
-  if (!FindFreePage(&r_fid)) {
+  auto guard = LockLatch();
+  while (true) {
+    // Another thread may have brought the page in while we were waiting for latch_.
+    if (PinFrame(page_id, &r_fid, record_access)) {
+      guard.unlock();
+      if (counted) {
+        counters_.hits_.fetch_add(1, std::memory_order_relaxed);
+      }
+      WaitForIo(r_fid);
+      return pages_ + r_fid;
+    }
+    // If the page was just written back by an eviction or the page cleaner, the disk copy is stale until the write
+    // ends. A page that is not resident cannot get a new write-back while we hold latch_.
+    if (!HasWriteback(page_id)) {
+      break;
+    }
+    guard.unlock();
+    WaitForWritebacks(page_id, 0);
+    guard.lock();
+  }
+  Victim victim;
+  BufferAccessStrategy::Slot *slot = nullptr;
+  bool found;
+  if (strategy != nullptr) {
+    slot = strategy->NextSlot(instance_index_, num_instances_);
+    found = FindRingFrame(*slot, &r_fid, &victim);
+  } else {
+    found = FindFreePage(&r_fid, &victim);
+  }
+  if (!found) {
+    if (counted) {
+      counters_.pin_failures_.fetch_add(1, std::memory_order_relaxed);
+    }
     return nullptr;
   }
-  ResetPage(r_fid);
-  page_table_.insert(std::make_pair(page_id, r_fid));
-  pages_[r_fid].page_id_ = page_id;
-  pages_[r_fid].pin_count_ = 1;
-  replacer_->Pin(r_fid);
-  disk_manager_->ReadPage(page_id, pages_[r_fid].GetData());
+  if (slot != nullptr) {
+    slot->frame_id_ = r_fid;
+    slot->page_id_ = page_id;
+  }
+  if (counted) {
+    counters_.misses_.fetch_add(1, std::memory_order_relaxed);
+  }
+  // Threads asking for the same page from now on find the frame and wait on it instead of on latch_.
+  PublishFrame(r_fid, page_id, record_access, false);
+  guard.unlock();
+  LoadFrame(r_fid, page_id, victim, true);
   return pages_ + r_fid;
 }
 
+void BufferPoolManagerInstance::FetchPgsImp(const page_id_t *page_ids, size_t num_pages, Page **pages) {
+  FetchFrames(page_ids, num_pages, pages, true);
+}
+
+void BufferPoolManagerInstance::FetchFrames(const page_id_t *page_ids, size_t num_pages, Page **pages,
+                                            bool record_access) {
+  // Only fetches on behalf of callers are counted, not prefetches.
+  const bool counted = record_access;
+  // Pin the resident pages without latch_, like FetchFrame does.
+  std::vector<size_t> misses;
+  frame_id_t r_fid;
+  for (size_t i = 0; i < num_pages; i++) {
+    if (PinFrame(page_ids[i], &r_fid, record_access)) {
+      if (counted) {
+        counters_.hits_.fetch_add(1, std::memory_order_relaxed);
+      }
+      pages[i] = pages_ + r_fid;
+    } else {
+      misses.push_back(i);
+    }
+  }
+
+  // Find frames for all misses under one acquisition of latch_. A page whose last write-back is still on its way to
+  // disk is left to FetchFrame, which waits for it without holding up the rest of the batch.
+  std::vector<std::pair<page_id_t, frame_id_t>> loads;
+  std::vector<Victim> victims;
+  std::vector<size_t> deferred;
+  if (!misses.empty()) {
+    auto guard = LockLatch();
+    for (size_t i : misses) {
+      page_id_t page_id = page_ids[i];
+      // The page may have come in since, e.g. as an earlier duplicate in this batch.
+      if (PinFrame(page_id, &r_fid, record_access)) {
+        if (counted) {
+          counters_.hits_.fetch_add(1, std::memory_order_relaxed);
+        }
+        pages[i] = pages_ + r_fid;
+        continue;
+      }
+      if (HasWriteback(page_id)) {
+        deferred.push_back(i);
+        continue;
+      }
+      Victim victim;
+      if (!FindFreePage(&r_fid, &victim)) {
+        if (counted) {
+          counters_.pin_failures_.fetch_add(1, std::memory_order_relaxed);
+        }
+        pages[i] = nullptr;
+        continue;
+      }
+      if (counted) {
+        counters_.misses_.fetch_add(1, std::memory_order_relaxed);
+      }
+      PublishFrame(r_fid, page_id, record_access, false);
+      loads.emplace_back(page_id, r_fid);
+      victims.push_back(victim);
+      pages[i] = pages_ + r_fid;
+    }
+  }
+  if (counted) {
+    counters_.fetches_.fetch_add(num_pages - deferred.size(), std::memory_order_relaxed);
+  }
+
+  // Retire the victims and take what we can from the compressed cache. Then read the rest in page id order, one read
+  // per run of consecutive pages, with all the runs in flight at once.
+  std::vector<std::pair<page_id_t, frame_id_t>> reads;
+  for (size_t j = 0; j < loads.size(); j++) {
+    auto [page_id, frame_id] = loads[j];
+    RetireVictim(frame_id, victims[j]);
+    if (ServeFromMapping(frame_id, page_id)) {
+      continue;
+    }
+    pages_[frame_id].ResetMemory();
+    if (!ReadFromCompressedCache(page_id, pages_[frame_id].GetData())) {
+      reads.push_back(loads[j]);
+    }
+  }
+  std::sort(reads.begin(), reads.end());
+  std::vector<char *> page_data(reads.size());
+  std::vector<std::future<void>> read_futures;
+  for (size_t run = 0; run < reads.size();) {
+    size_t end = run;
+    do {
+      page_data[end] = pages_[reads[end].second].GetData();
+      end++;
+    } while (end < reads.size() && reads[end].first == reads[end - 1].first + 1);
+    read_futures.push_back(disk_manager_->ReadPagesAsync(reads[run].first, page_data.data() + run, end - run));
+    run = end;
+  }
+  for (auto &read : read_futures) {
+    read.wait();
+  }
+  for (auto &load : loads) {
+    FinishLoad(load.second);
+  }
+
+  for (size_t i : deferred) {
+    pages[i] = FetchFrame(page_ids[i], record_access);
+  }
+  // Hits may be on pages that other threads are still reading in.
+  for (size_t i = 0; i < num_pages; i++) {
+    if (pages[i] != nullptr) {
+      WaitForIo(static_cast<frame_id_t>(pages[i] - pages_));
+    }
+  }
+}
+
 bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
   // 0.   Make sure you call DeallocatePage!
   // 1.   Search the page table for the requested page (P).
   // 1.   If P does not exist, return true.
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
-  std::lock_guard<std::mutex> guard(latch_);
-  auto page_it = page_table_.find(page_id);
-  if (page_it == page_table_.end()) {  // not exist
-    return true;
-  }
-  if (pages_[page_it->second].GetPinCount() > 0) {
+  if (!RemovePage(page_id)) {
     return false;
   }
-  if (pages_[page_it->second].IsDirty()) {
-    disk_manager_->WritePage(page_id, pages_[page_it->second].GetData());
-    pages_[page_it->second].is_dirty_ = false;
+  DeallocatePage(page_id);
+  return true;
+}
+
+bool BufferPoolManagerInstance::RemovePage(page_id_t page_id) {
+  if (compressed_cache_ != nullptr) {
+    // A victim copy of P may be on its way into the compressed cache. Let it land, then drop it.
+    WaitForWritebacks(page_id, 0);
+    compressed_cache_->Erase(page_id);
   }
-  frame_id_t frame_id = page_it->second;
-  page_table_.erase(page_it);
-  ResetPage(frame_id);
-  free_list_.push_back(frame_id);
-  replacer_->Pin(frame_id);
+  {
+    auto guard = LockLatch();
+    auto &stripe = GetStripe(page_id);
+    std::lock_guard<std::mutex> stripe_guard(stripe.latch_);
+    auto page_it = stripe.table_.find(page_id);
+    if (page_it != stripe.table_.end()) {
+      frame_id_t frame_id = page_it->second;
+      std::lock_guard<std::mutex> frame_guard(frame_latches_[frame_id]);
+      if (pages_[frame_id].GetPinCount() > 0) {
+        return false;
+      }
+      // The page is gone, so there is no point in writing back its contents.
+      stripe.table_.erase(page_it);
+      replacer_->Remove(frame_id);
+      pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+      pages_[frame_id].is_dirty_ = false;
+      // A frame that Resize is retiring stays out of the free list.
+      if (static_cast<size_t>(frame_id) < pool_size_) {
+        free_list_.Push(frame_id);
+      }
+    }
+  }
+  // No new write-back of P can start now, but one may still be in flight, from the page cleaner or from the eviction
+  // that took P out of the pool. Its id must not be handed out again before that write lands.
+  WaitForWritebacks(page_id, 0);
   return true;
 }
 
+bool BufferPoolManagerInstance::DiscardSegmentImp(segment_id_t segment_id) {
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < max_pool_size_; i++) {
+    std::lock_guard<std::mutex> frame_guard(frame_latches_[i]);
+    if (pages_[i].page_id_ != INVALID_PAGE_ID && DiskManager::GetSegmentId(pages_[i].page_id_) == segment_id) {
+      page_ids.push_back(pages_[i].page_id_);
+    }
+  }
+  bool discarded = true;
+  for (page_id_t page_id : page_ids) {
+    discarded = RemovePage(page_id) && discarded;
+  }
+  // Pages evicted before we looked may still be on their way to disk.
+  {
+    std::unique_lock<std::mutex> guard(writeback_latch_);
+    auto in_segment = [&](const auto &writeback) {
+      return DiskManager::GetSegmentId(writeback.first) == segment_id;
+    };
+    writeback_cv_.wait(guard,
+                       [&] { return std::none_of(writeback_pages_.begin(), writeback_pages_.end(), in_segment); });
+  }
+  if (compressed_cache_ != nullptr) {
+    const page_id_t first_page_id = DiskManager::GetFirstPageId(segment_id);
+    const page_id_t last_page_id = first_page_id + static_cast<page_id_t>(DiskManager::SEGMENT_MAX_PAGES - 1);
+    compressed_cache_->EraseRange(first_page_id, last_page_id);
+  }
+  return discarded;
+}
+
 bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) {
-  std::lock_guard<std::mutex> guard(latch_);
-  auto page_it = page_table_.find(page_id);
-  if (page_it == page_table_.end()) {
+  auto &stripe = GetStripe(page_id);
+  std::unique_lock<std::mutex> stripe_guard(stripe.latch_);
+  auto page_it = stripe.table_.find(page_id);
+  if (page_it == stripe.table_.end()) {
     // LOG_WARN("can't find page_id %d from pagetable", page_id);
     return false;
   }
   frame_id_t frame_id = page_it->second;
+  std::lock_guard<std::mutex> frame_guard(frame_latches_[frame_id]);
+  stripe_guard.unlock();
+  return UnpinFrameLocked(frame_id, is_dirty);
+}
+
+bool BufferPoolManagerInstance::UnpinFrameImp(Page *page, bool is_dirty) {
+  auto frame_id = static_cast<frame_id_t>(page - pages_);
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < max_pool_size_, "page does not belong to this BPI");
+  std::lock_guard<std::mutex> frame_guard(frame_latches_[frame_id]);
+  return UnpinFrameLocked(frame_id, is_dirty);
+}
+
+bool BufferPoolManagerInstance::UnpinFrameLocked(frame_id_t frame_id, bool is_dirty) {
   if (pages_[frame_id].pin_count_ == 0) {
     return false;
   }
-  pages_[frame_id].pin_count_--;
   pages_[frame_id].is_dirty_ |= is_dirty;
-  if (pages_[frame_id].pin_count_ <= 0) {
+  if (--pages_[frame_id].pin_count_ == 0) {
     replacer_->Unpin(frame_id);
+    num_pinned_frames_--;
   }
   return true;
 }
 
 page_id_t BufferPoolManagerInstance::AllocatePage() {
-  const page_id_t next_page_id = next_page_id_;
-  next_page_id_ += num_instances_;
+  // Only ids below next_page_id_ are reused, so a page id never comes from both the free page map and the counter.
+  page_id_t page_id = disk_manager_->AllocateFreePage(next_page_id_, num_instances_, instance_index_);
+  if (page_id != INVALID_PAGE_ID) {
+    ValidatePageId(page_id);
+    return page_id;
+  }
+  // The map may still have the id as free from an earlier run on the same file, which ReservePage takes care of.
+  page_id_t next_page_id;
+  do {
+    next_page_id = next_page_id_;
+    // The ids past the main segment belong to the segment files.
+    if (static_cast<size_t>(next_page_id) >= DiskManager::SEGMENT_MAX_PAGES) {
+      return INVALID_PAGE_ID;
+    }
+    next_page_id_ += num_instances_;
+  } while (!disk_manager_->ReservePage(next_page_id));
   ValidatePageId(next_page_id);
   return next_page_id;
 }
 
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
+
 void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
   assert(page_id % num_instances_ == instance_index_);  // allocated pages mod back to this BPI
 }
@@ -14,16 +14,72 @@
 
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : num_pages_(num_pages) {
+  states_ = new std::atomic<uint8_t>[num_pages];
+  for (size_t i = 0; i < num_pages; i++) {
+    states_[i] = NOT_EVICTABLE;
+  }
+}
 
-ClockReplacer::~ClockReplacer() = default;
+ClockReplacer::~ClockReplacer() { delete[] states_; }
 
-bool ClockReplacer::Victim(frame_id_t *frame_id) { return false; }
+bool ClockReplacer::Victim(frame_id_t *frame_id) {
+  if (Size() == 0) {
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(victim_latch_);
+  // The first full turn clears every reference bit it passes, so the second one finds a victim unless concurrent Pin
+  // and Unpin calls keep taking them away. Give up then rather than chase them.
+  for (size_t i = 0; i < 2 * num_pages_; i++) {
+    auto &state = states_[clock_hand_];
+    uint8_t expected = state;
+    clock_hand_ = (clock_hand_ + 1) % num_pages_;
+    if (expected == EVICTABLE_REFERENCED) {
+      state.compare_exchange_strong(expected, EVICTABLE);
+    } else if (expected == EVICTABLE && state.compare_exchange_strong(expected, NOT_EVICTABLE)) {
+      *frame_id = static_cast<frame_id_t>(&state - states_);
+      GetShard(*frame_id)--;
+      return true;
+    }
+  }
+  return false;
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+void ClockReplacer::Pin(frame_id_t frame_id) {
+  if (states_[frame_id].exchange(NOT_EVICTABLE) != NOT_EVICTABLE) {
+    GetShard(frame_id)--;
+  }
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+void ClockReplacer::Unpin(frame_id_t frame_id) {
+  // Count the frame before it becomes visible to Victim and Pin, so that their decrement never comes first.
+  auto &shard = GetShard(frame_id);
+  shard++;
+  if (states_[frame_id].exchange(EVICTABLE_REFERENCED) != NOT_EVICTABLE) {
+    shard--;
+  }
+}
 
-size_t ClockReplacer::Size() { return 0; }
+size_t ClockReplacer::Size() {
+  int64_t size = 0;
+  for (auto &shard : shards_) {
+    size += shard.count_.load(std::memory_order_relaxed);
+  }
+  return size > 0 ? static_cast<size_t>(size) : 0;
+}
+
+void ClockReplacer::PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_frames) {
+  std::lock_guard<std::mutex> guard(victim_latch_);
+  // Frames the hand would evict on its first turn come first, then the referenced ones it evicts on the second turn.
+  for (uint8_t wanted : {EVICTABLE, EVICTABLE_REFERENCED}) {
+    for (size_t i = 0; i < num_pages_ && max_frames > 0; i++) {
+      size_t frame_id = (clock_hand_ + i) % num_pages_;
+      if (states_[frame_id] == wanted) {
+        frame_ids->push_back(static_cast<frame_id_t>(frame_id));
+        max_frames--;
+      }
+    }
+  }
+}
 
 }  // namespace bustub
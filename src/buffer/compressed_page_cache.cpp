@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.cpp
+//
+// Identification: src/buffer/compressed_page_cache.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <cstring>
+#include <iterator>
+
+#include "common/util/lz_util.h"
+
+namespace bustub {
+
+void CompressedPageCache::Insert(page_id_t page_id, const char *page_data) {
+  char buffer[MAX_COMPRESSED_SIZE];
+  size_t size = LzUtil::Compress(page_data, PAGE_SIZE, buffer, sizeof(buffer));
+  std::unique_ptr<char[]> data;
+  if (size != 0 && size <= capacity_) {
+    data = std::make_unique<char[]>(size);
+    memcpy(data.get(), buffer, size);
+  }
+
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = index_.find(page_id);
+  if (it != index_.end()) {
+    EraseLocked(it);
+  }
+  if (data == nullptr) {
+    return;  // incompressible, but the older copy is stale anyway
+  }
+  while (size_ + size > capacity_) {
+    EraseLocked(index_.find(entries_.back().page_id_));
+  }
+  entries_.push_front(Entry{page_id, std::move(data), size});
+  index_[page_id] = entries_.begin();
+  size_ += size;
+}
+
+bool CompressedPageCache::Get(page_id_t page_id, char *page_data) {
+  std::list<Entry> taken;
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    auto it = index_.find(page_id);
+    if (it == index_.end()) {
+      return false;
+    }
+    taken.splice(taken.begin(), entries_, it->second);
+    size_ -= taken.front().size_;
+    index_.erase(it);
+  }
+  bool ok = LzUtil::Decompress(taken.front().data_.get(), taken.front().size_, page_data, PAGE_SIZE);
+  BUSTUB_ASSERT(ok, "corrupt compressed page");
+  return ok;
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  auto it = index_.find(page_id);
+  if (it != index_.end()) {
+    EraseLocked(it);
+  }
+}
+
+void CompressedPageCache::EraseRange(page_id_t first_page_id, page_id_t last_page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  for (auto it = entries_.begin(); it != entries_.end();) {
+    auto next = std::next(it);
+    if (it->page_id_ >= first_page_id && it->page_id_ <= last_page_id) {
+      EraseLocked(index_.find(it->page_id_));
+    }
+    it = next;
+  }
+}
+
+size_t CompressedPageCache::GetNumPages() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return entries_.size();
+}
+
+size_t CompressedPageCache::GetSize() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return size_;
+}
+
+void CompressedPageCache::EraseLocked(std::unordered_map<page_id_t, std::list<Entry>::iterator>::iterator it) {
+  size_ -= it->second->size_;
+  entries_.erase(it->second);
+  index_.erase(it);
+}
+
+}  // namespace bustub
@@ -0,0 +1,48 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extent_allocator.cpp
+//
+// Identification: src/buffer/extent_allocator.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/extent_allocator.h"
+
+namespace bustub {
+
+page_id_t ExtentAllocator::Allocate(DiskManager *disk_manager) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!returned_.empty()) {
+    page_id_t page_id = returned_.back();
+    returned_.pop_back();
+    return page_id;
+  }
+  if (next_page_id_ == end_page_id_) {
+    next_page_id_ = disk_manager->AllocateExtent(extent_size_, segment_id_);
+    end_page_id_ = next_page_id_ + static_cast<page_id_t>(extent_size_);
+    num_extents_++;
+  }
+  return next_page_id_++;
+}
+
+void ExtentAllocator::Return(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  returned_.push_back(page_id);
+}
+
+void ExtentAllocator::Reset() {
+  std::lock_guard<std::mutex> guard(latch_);
+  next_page_id_ = end_page_id_ = INVALID_PAGE_ID;
+  returned_.clear();
+}
+
+size_t ExtentAllocator::GetNumExtents() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return num_extents_;
+}
+
+}  // namespace bustub
@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+FrameArena::FrameArena(size_t num_frames, HugePageMode huge_page_mode, bool prefault) {
+  size_ = num_frames * PAGE_SIZE;
+  if (huge_page_mode != HugePageMode::NONE) {
+    size_ = (size_ + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+  size_ = std::max<size_t>(size_, PAGE_SIZE);
+
+  void *addr = MAP_FAILED;
+  if (huge_page_mode == HugePageMode::EXPLICIT) {
+    addr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    explicit_huge_pages_ = addr != MAP_FAILED;
+  }
+  if (addr == MAP_FAILED && huge_page_mode != HugePageMode::NONE) {
+    // Transparent huge pages are only used for 2MB-aligned ranges, so map a huge page more than needed and trim the
+    // mapping down to an aligned one.
+    void *raw = mmap(nullptr, size_ + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw != MAP_FAILED) {
+      auto start = reinterpret_cast<uintptr_t>(raw);
+      auto aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+      if (aligned > start) {
+        munmap(raw, aligned - start);
+      }
+      if (aligned + size_ < start + size_ + HUGE_PAGE_SIZE) {
+        munmap(reinterpret_cast<void *>(aligned + size_), start + HUGE_PAGE_SIZE - aligned);
+      }
+      addr = reinterpret_cast<void *>(aligned);
+      // Only a hint: the kernel may have transparent huge pages disabled.
+      madvise(addr, size_, MADV_HUGEPAGE);
+    }
+  }
+  if (addr == MAP_FAILED && huge_page_mode == HugePageMode::NONE) {
+    addr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+  if (addr == MAP_FAILED) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot map a frame arena of " + std::to_string(size_) + " bytes");
+  }
+  data_ = static_cast<char *>(addr);
+
+  if (prefault) {
+    Prefault(0, size_ / PAGE_SIZE);
+  }
+}
+
+FrameArena::~FrameArena() { munmap(data_, size_); }
+
+void FrameArena::Prefault(size_t first_frame, size_t num_frames) {
+  // Write to every page so that it is backed now. With huge pages, the first write to each 2MB range is enough,
+  // but touching every PAGE_SIZE step works for both.
+  for (size_t offset = first_frame * PAGE_SIZE; offset < (first_frame + num_frames) * PAGE_SIZE; offset += PAGE_SIZE) {
+    data_[offset] = 0;
+  }
+}
+
+void FrameArena::Release(size_t first_frame, size_t num_frames) {
+  auto start = first_frame * PAGE_SIZE;
+  auto end = (first_frame + num_frames) * PAGE_SIZE;
+  if (explicit_huge_pages_) {
+    // MAP_HUGETLB mappings can only be released in whole huge pages.
+    start = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    end = end / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+  }
+  if (start < end) {
+    madvise(data_ + start, end - start, MADV_DONTNEED);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,54 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_frame_stack.cpp
+//
+// Identification: src/buffer/free_frame_stack.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/free_frame_stack.h"
+
+namespace bustub {
+
+FreeFrameStack::FreeFrameStack(size_t num_frames) : size_(num_frames) {
+  next_ = new std::atomic<uint32_t>[num_frames];
+  for (size_t i = 0; i < num_frames; i++) {
+    next_[i].store(i + 1 < num_frames ? static_cast<uint32_t>(i + 1) : EMPTY, std::memory_order_relaxed);
+  }
+  head_.store(num_frames > 0 ? 0 : EMPTY, std::memory_order_relaxed);
+}
+
+FreeFrameStack::~FreeFrameStack() { delete[] next_; }
+
+void FreeFrameStack::Push(frame_id_t frame_id) {
+  // Count the frame before it becomes visible, so that a racing Pop can never drive size_ below zero.
+  size_.fetch_add(1, std::memory_order_relaxed);
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  uint64_t new_head;
+  do {
+    next_[frame_id].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    new_head = (((head >> 32) + 1) << 32) | static_cast<uint32_t>(frame_id);
+  } while (!head_.compare_exchange_weak(head, new_head, std::memory_order_release, std::memory_order_relaxed));
+}
+
+bool FreeFrameStack::Pop(frame_id_t *frame_id) {
+  uint64_t head = head_.load(std::memory_order_acquire);
+  uint64_t new_head;
+  uint32_t top;
+  do {
+    top = static_cast<uint32_t>(head);
+    if (top == EMPTY) {
+      return false;
+    }
+    new_head = (((head >> 32) + 1) << 32) | next_[top].load(std::memory_order_relaxed);
+  } while (!head_.compare_exchange_weak(head, new_head, std::memory_order_acquire, std::memory_order_acquire));
+  size_.fetch_sub(1, std::memory_order_relaxed);
+  *frame_id = static_cast<frame_id_t>(top);
+  return true;
+}
+
+}  // namespace bustub
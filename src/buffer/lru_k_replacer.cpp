@@ -0,0 +1,118 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.cpp
+//
+// Identification: src/buffer/lru_k_replacer.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/lru_k_replacer.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+LRUKReplacer::LRUKReplacer(size_t num_pages, size_t k) : k_(k), frames_(num_pages) {
+  BUSTUB_ASSERT(k > 0, "LRU-K needs to keep at least one access per frame");
+}
+
+LRUKReplacer::~LRUKReplacer() = default;
+
+bool LRUKReplacer::Victim(frame_id_t *frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (cold_frames_.empty() && hot_frames_.empty()) {
+    return false;
+  }
+  *frame_id = cold_frames_.empty() ? hot_frames_.begin()->second : cold_frames_.begin()->second;
+  Erase(*frame_id);
+  frames_[*frame_id].history_.clear();
+  return true;
+}
+
+void LRUKReplacer::Pin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (frames_[frame_id].evictable_) {
+    Erase(frame_id);
+  }
+}
+
+void LRUKReplacer::Unpin(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (!frames_[frame_id].evictable_) {
+    Insert(frame_id);
+  }
+}
+
+void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  FrameInfo &frame = frames_[frame_id];
+  bool evictable = frame.evictable_;
+  if (evictable) {
+    Erase(frame_id);
+  }
+  current_timestamp_++;
+  if (frame_id == last_frame_id_ && !frame.history_.empty()) {
+    frame.history_.back() = current_timestamp_;
+  } else {
+    frame.history_.push_back(current_timestamp_);
+    if (frame.history_.size() > k_) {
+      frame.history_.pop_front();
+    }
+  }
+  last_frame_id_ = frame_id;
+  if (evictable) {
+    Insert(frame_id);
+  }
+}
+
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (frames_[frame_id].evictable_) {
+    Erase(frame_id);
+  }
+  frames_[frame_id].history_.clear();
+  if (last_frame_id_ == frame_id) {
+    last_frame_id_ = -1;
+  }
+}
+
+size_t LRUKReplacer::Size() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return cold_frames_.size() + hot_frames_.size();
+}
+
+void LRUKReplacer::PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_frames) {
+  std::lock_guard<std::mutex> guard(latch_);
+  for (auto it = cold_frames_.begin(); it != cold_frames_.end() && max_frames > 0; ++it, --max_frames) {
+    frame_ids->push_back(it->second);
+  }
+  for (auto it = hot_frames_.begin(); it != hot_frames_.end() && max_frames > 0; ++it, --max_frames) {
+    frame_ids->push_back(it->second);
+  }
+}
+
+void LRUKReplacer::Insert(frame_id_t frame_id) {
+  FrameInfo &frame = frames_[frame_id];
+  // A frame that was read in without being accessed, e.g. by a prefetch, ranks as if it was accessed just now.
+  frame.key_ = frame.history_.empty() ? current_timestamp_ : frame.history_.front();
+  if (frame.history_.size() < k_) {
+    cold_frames_.emplace(frame.key_, frame_id);
+  } else {
+    hot_frames_.emplace(frame.key_, frame_id);
+  }
+  frame.evictable_ = true;
+}
+
+void LRUKReplacer::Erase(frame_id_t frame_id) {
+  FrameInfo &frame = frames_[frame_id];
+  if (cold_frames_.erase({frame.key_, frame_id}) == 0) {
+    hot_frames_.erase({frame.key_, frame_id});
+  }
+  frame.evictable_ = false;
+}
+
+}  // namespace bustub
@@ -64,4 +64,11 @@ size_t LRUReplacer::Size() {
   return frames_.size();
 }
 
+void LRUReplacer::PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_frames) {
+  std::lock_guard<std::mutex> gaurd(latch_);
+  for (auto it = frames_.rbegin(); it != frames_.rend() && max_frames > 0; ++it, --max_frames) {
+    frame_ids->push_back(*it);
+  }
+}
+
 }  // namespace bustub
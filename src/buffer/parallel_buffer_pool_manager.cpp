@@ -17,12 +17,16 @@
 namespace bustub {
 
 ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                                                     LogManager *log_manager)
+                                                     LogManager *log_manager, ReplacerPolicy replacer_policy,
+                                                     HugePageMode huge_page_mode, bool prefault, size_t max_pool_size,
+                                                     size_t compressed_cache_size)
     : num_instances_(num_instances), pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
   // Allocate and create individual BufferPoolManagerInstances
   instances_.resize(num_instances_);
   for (size_t i = 0; i < num_instances_; i++) {
-    instances_[i] = new BufferPoolManagerInstance(pool_size_, num_instances_, i, disk_manager_, log_manager_);
+    instances_[i] = new BufferPoolManagerInstance(pool_size_, num_instances_, i, disk_manager_, log_manager_,
+                                                  replacer_policy, huge_page_mode, prefault, max_pool_size,
+                                                  compressed_cache_size);
   }
   next_instance_ = 0;
 }
@@ -35,8 +39,38 @@ ParallelBufferPoolManager::~ParallelBufferPoolManager() {
 }
 
 size_t ParallelBufferPoolManager::GetPoolSize() {
-  // Get size of all BufferPoolManagerInstances
-  return num_instances_ * pool_size_;
+  // Get size of all BufferPoolManagerInstances. They may differ for a moment while a Resize is going on.
+  size_t pool_size = 0;
+  for (auto instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+bool ParallelBufferPoolManager::Resize(size_t pool_size) {
+  // Page ids are striped over the instances by page_id % num_instances_, so the number of instances is fixed and each
+  // of them is resized instead. Resizes are serialized, so two of them cannot leave the instances at different sizes.
+  std::lock_guard<std::mutex> resize_guard(resize_latch_);
+  std::vector<size_t> old_pool_sizes;
+  for (auto instance : instances_) {
+    old_pool_sizes.push_back(instance->GetPoolSize());
+    if (!instance->Resize(pool_size)) {
+      // Put the instances that were resized back to their old sizes. Those sizes were valid, so this succeeds.
+      for (size_t i = 0; i + 1 < old_pool_sizes.size(); i++) {
+        instances_[i]->Resize(old_pool_sizes[i]);
+      }
+      return false;
+    }
+  }
+  return true;
+}
+
+BufferPoolMetrics ParallelBufferPoolManager::GetMetrics() {
+  BufferPoolMetrics metrics;
+  for (auto instance : instances_) {
+    metrics += instance->GetMetrics();
+  }
+  return metrics;
 }
 
 BufferPoolManager *ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) {
@@ -68,23 +102,41 @@ Page *ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) {
   // starting index and return nullptr
   // 2.   Bump the starting index (mod number of instances) to start search at a different BPMI each time this function
   // is called
-  std::lock_guard<std::mutex> guard(latch_);
-  auto start = next_instance_;
-  Page *page = nullptr;
-  while (true) {
-    // LOG_DEBUG("the next_instance is %lu,the start is %lu",next_instance_,start);
-    page = instances_[next_instance_]->NewPage(page_id);
-    next_instance_ = (next_instance_ + 1) % num_instances_;
-    // LOG_DEBUG("next_ins %lu and start %lu", next_instance_, start);
-    if (page != nullptr) {
-      // LOG_DEBUG("find new page");
-      break;
-    }
-    // LOG_DEBUG("the next_instance is %lu,the start is %lu",next_instance_,start);
-    if (next_instance_ == start) {
-      break;
+  // Concurrent callers get different starting instances from the atomic cursor, so they do not pile up on one BPMI.
+  // A first pass only tries instances with free frames, which allocate without evicting anything.
+  const size_t ticket = next_instance_.fetch_add(1);
+  const size_t start = ticket % num_instances_;
+  for (bool need_free_frame : {true, false}) {
+    for (size_t i = 0; i < num_instances_; i++) {
+      auto instance_index = (start + i) % num_instances_;
+      BufferPoolManagerInstance *instance = instances_[instance_index];
+      if (need_free_frame && instance->GetFreeFrameCount() == 0) {
+        continue;
+      }
+      Page *page = instance->NewPage(page_id);
+      if (page != nullptr) {
+        // Continue after the instance that had room, unless other callers took tickets in the meantime; their starts
+        // already spread them over the instances, and overwriting the cursor would send the next ones back here.
+        if (instance_index != start) {
+          size_t expected = ticket + 1;
+          next_instance_.compare_exchange_strong(expected, ticket + 1 + (instance_index + num_instances_ - start));
+        }
+        return page;
+      }
     }
   }
+  return nullptr;
+}
+
+Page *ParallelBufferPoolManager::NewPgExtentImp(page_id_t *page_id, ExtentAllocator *extent) {
+  const page_id_t new_page_id = extent->Allocate(disk_manager_);
+  Page *page = instances_[new_page_id % num_instances_]->NewPageAt(new_page_id);
+  if (page == nullptr) {
+    // Hand the id out again next time, rather than leave a hole in the extent.
+    extent->Return(new_page_id);
+    return nullptr;
+  }
+  *page_id = new_page_id;
   return page;
 }
 
@@ -93,11 +145,58 @@ bool ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) {
   return GetBufferPoolManager(page_id)->DeletePage(page_id);
 }
 
+void ParallelBufferPoolManager::PrefetchPgImp(page_id_t page_id) {
+  // Prefetch page_id on the responsible BufferPoolManagerInstance
+  GetBufferPoolManager(page_id)->PrefetchPage(page_id);
+}
+
+void ParallelBufferPoolManager::FetchPgsImp(const page_id_t *page_ids, size_t num_pages, Page **pages) {
+  // Split the batch by responsible BufferPoolManagerInstance, remembering where each page goes in the result
+  std::vector<std::vector<page_id_t>> instance_page_ids(num_instances_);
+  std::vector<std::vector<size_t>> instance_indexes(num_instances_);
+  for (size_t i = 0; i < num_pages; i++) {
+    auto ins_id = page_ids[i] % num_instances_;
+    instance_page_ids[ins_id].push_back(page_ids[i]);
+    instance_indexes[ins_id].push_back(i);
+  }
+  std::vector<Page *> instance_pages;
+  for (size_t ins_id = 0; ins_id < num_instances_; ins_id++) {
+    if (instance_page_ids[ins_id].empty()) {
+      continue;
+    }
+    instance_pages.resize(instance_page_ids[ins_id].size());
+    instances_[ins_id]->FetchPages(instance_page_ids[ins_id].data(), instance_page_ids[ins_id].size(),
+                                   instance_pages.data());
+    for (size_t j = 0; j < instance_pages.size(); j++) {
+      pages[instance_indexes[ins_id][j]] = instance_pages[j];
+    }
+  }
+}
+
+Page *ParallelBufferPoolManager::FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  // Fetch page for page_id from responsible BufferPoolManagerInstance, which uses its own ring of the strategy
+  return GetBufferPoolManager(page_id)->FetchPageWithStrategy(page_id, strategy);
+}
+
+bool ParallelBufferPoolManager::UnpinFrameImp(Page *page, bool is_dirty) {
+  // Unpin page from responsible BufferPoolManagerInstance
+  return GetBufferPoolManager(page->GetPageId())->UnpinFrame(page, is_dirty);
+}
+
+bool ParallelBufferPoolManager::DiscardSegmentImp(segment_id_t segment_id) {
+  bool discarded = true;
+  for (auto instance : instances_) {
+    discarded = instance->DiscardSegment(segment_id) && discarded;
+  }
+  return discarded;
+}
+
 void ParallelBufferPoolManager::FlushAllPgsImp() {
-  // flush all pages from all BufferPoolManagerInstances
+  // flush all pages from all BufferPoolManagerInstances, then sync the file they share once
   for (auto instance : instances_) {
-    instance->FlushAllPages();
+    instance->WriteBackAllPages();
   }
+  disk_manager_->SyncData();
 }
 
 }  // namespace bustub
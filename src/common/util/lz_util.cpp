@@ -0,0 +1,168 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz_util.cpp
+//
+// Identification: src/common/util/lz_util.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "common/util/lz_util.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr int HASH_BITS = 12;
+/** A length nibble of this value is followed by more length bytes. */
+constexpr size_t LENGTH_ESCAPE = 15;
+
+uint32_t Load32(const char *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint32_t Hash(uint32_t value) { return (value * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Append the part of a length that did not fit in its nibble. */
+bool PutLength(size_t length, char **out, const char *out_end) {
+  for (; length >= 255; length -= 255) {
+    if (*out == out_end) {
+      return false;
+    }
+    *(*out)++ = static_cast<char>(255);
+  }
+  if (*out == out_end) {
+    return false;
+  }
+  *(*out)++ = static_cast<char>(length);
+  return true;
+}
+
+/** Add the length bytes following an escaped nibble to length. */
+bool GetLength(const uint8_t **in, const uint8_t *in_end, size_t *length) {
+  uint8_t byte;
+  do {
+    if (*in == in_end) {
+      return false;
+    }
+    byte = *(*in)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/** Append a sequence. A match length of 0 makes it the last sequence of the block. */
+bool PutSequence(const char *literals, size_t literal_len, size_t offset, size_t match_len, char **out,
+                 const char *out_end) {
+  if (*out == out_end) {
+    return false;
+  }
+  size_t match_code = match_len == 0 ? 0 : match_len - LzUtil::MIN_MATCH;
+  *(*out)++ = static_cast<char>(std::min(literal_len, LENGTH_ESCAPE) << 4 | std::min(match_code, LENGTH_ESCAPE));
+  if (literal_len >= LENGTH_ESCAPE && !PutLength(literal_len - LENGTH_ESCAPE, out, out_end)) {
+    return false;
+  }
+  if (static_cast<size_t>(out_end - *out) < literal_len) {
+    return false;
+  }
+  memcpy(*out, literals, literal_len);
+  *out += literal_len;
+  if (match_len == 0) {
+    return true;
+  }
+  if (out_end - *out < 2) {
+    return false;
+  }
+  *(*out)++ = static_cast<char>(offset & 0xff);
+  *(*out)++ = static_cast<char>(offset >> 8);
+  return match_code < LENGTH_ESCAPE || PutLength(match_code - LENGTH_ESCAPE, out, out_end);
+}
+
+}  // namespace
+
+size_t LzUtil::Compress(const char *src, size_t src_len, char *dst, size_t dst_capacity) {
+  // Positions are stored plus one, so that 0 means empty.
+  uint32_t table[1 << HASH_BITS] = {0};
+  char *out = dst;
+  const char *out_end = dst + dst_capacity;
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + MIN_MATCH <= src_len) {
+    uint32_t sequence = Load32(src + pos);
+    uint32_t &slot = table[Hash(sequence)];
+    size_t candidate = slot;
+    slot = static_cast<uint32_t>(pos + 1);
+    if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || Load32(src + candidate - 1) != sequence) {
+      pos++;
+      continue;
+    }
+    size_t match = candidate - 1;
+    size_t match_len = MIN_MATCH;
+    while (pos + match_len < src_len && src[match + match_len] == src[pos + match_len]) {
+      match_len++;
+    }
+    if (!PutSequence(src + anchor, pos - anchor, pos - match, match_len, &out, out_end)) {
+      return 0;
+    }
+    pos += match_len;
+    anchor = pos;
+  }
+  if (!PutSequence(src + anchor, src_len - anchor, 0, 0, &out, out_end)) {
+    return 0;
+  }
+  return out - dst;
+}
+
+bool LzUtil::Decompress(const char *src, size_t src_len, char *dst, size_t dst_len) {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *in_end = in + src_len;
+  char *out = dst;
+  char *out_end = dst + dst_len;
+  while (in < in_end) {
+    uint8_t token = *in++;
+    size_t literal_len = token >> 4;
+    if (literal_len == LENGTH_ESCAPE && !GetLength(&in, in_end, &literal_len)) {
+      return false;
+    }
+    if (static_cast<size_t>(in_end - in) < literal_len || static_cast<size_t>(out_end - out) < literal_len) {
+      return false;
+    }
+    memcpy(out, in, literal_len);
+    in += literal_len;
+    out += literal_len;
+    if (in == in_end) {
+      break;  // the last sequence has no match
+    }
+    if (in_end - in < 2) {
+      return false;
+    }
+    size_t offset = in[0] | in[1] << 8;
+    in += 2;
+    size_t match_len = token & 0xf;
+    if (match_len == LENGTH_ESCAPE && !GetLength(&in, in_end, &match_len)) {
+      return false;
+    }
+    match_len += MIN_MATCH;
+    if (offset == 0 || offset > static_cast<size_t>(out - dst) || static_cast<size_t>(out_end - out) < match_len) {
+      return false;
+    }
+    // The match may overlap the bytes it produces, e.g. a run of one byte has offset 1, so copy forward one by one.
+    const char *from = out - offset;
+    for (size_t i = 0; i < match_len; i++) {
+      out[i] = from[i];
+    }
+    out += match_len;
+  }
+  return out == out_end;
+}
+
+}  // namespace bustub
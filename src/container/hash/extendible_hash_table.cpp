@@ -24,20 +24,23 @@ namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                     const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+                                     const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                                     segment_id_t segment_id)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)),
+      extent_(ExtentAllocator::DEFAULT_EXTENT_SIZE, segment_id) {
   //  implement me!
-  auto page = buffer_pool_manager_->NewPage(&directory_page_id_);
-  if (page != nullptr) {
-    HashTableDirectoryPage *dir_page = reinterpret_cast<HashTableDirectoryPage *>(page);
+  BasicPageGuard dir_guard = buffer_pool_manager_->NewPageGuarded(&directory_page_id_, &extent_);
+  if (dir_guard.IsValid()) {
+    auto *dir_page = dir_guard.AsMut<HashTableDirectoryPage>();
     dir_page->SetPageId(directory_page_id_);
     page_id_t bucket_id;
-    Page *bucket = buffer_pool_manager_->NewPage(&bucket_id);
-    if (bucket != nullptr) {
+    BasicPageGuard bucket_guard = buffer_pool_manager_->NewPageGuarded(&bucket_id, &extent_);
+    if (bucket_guard.IsValid()) {
       dir_page->SetBucketPageId(0, bucket_id);
-      buffer_pool_manager_->UnpinPage(bucket_id, true);
+      bucket_guard.SetDirty();
     }
-    buffer_pool_manager_->UnpinPage(directory_page_id_, true);
   }
 }
 
@@ -57,7 +60,7 @@ uint32_t HASH_TABLE_TYPE::Hash(KeyType key) {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline uint32_t HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page) {
+inline uint32_t HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, const HashTableDirectoryPage *dir_page) {
   uint32_t mask = dir_page->GetGlobalDepthMask();
   uint32_t idx = Hash(key) & mask;
   // LOG_DEBUG("mask is 0x%x and idx is 0x%x",mask,idx);
@@ -65,19 +68,14 @@ inline uint32_t HASH_TABLE_TYPE::KeyToDirectoryIndex(KeyType key, HashTableDirec
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-inline uint32_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page) {
+inline uint32_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, const HashTableDirectoryPage *dir_page) {
   uint32_t idx = KeyToDirectoryIndex(key, dir_page);
   return dir_page->GetBucketPageId(idx);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage() {
-  return reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->FetchPage(directory_page_id_));
-}
-
-template <typename KeyType, typename ValueType, typename KeyComparator>
-HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) {
-  return reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(buffer_pool_manager_->FetchPage(bucket_page_id));
+  return reinterpret_cast<HashTableDirectoryPage *>(buffer_pool_manager_->FetchPage(directory_page_id_)->GetData());
 }
 
 /*****************************************************************************
@@ -86,18 +84,13 @@ HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_i
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  BasicPageGuard dir_guard = buffer_pool_manager_->FetchPageBasic(directory_page_id_);
+  auto page_id = KeyToPageId(key, dir_guard.As<HashTableDirectoryPage>());
 
-  auto page_idx = KeyToDirectoryIndex(key, dir_page);
-  auto page_id = dir_page->GetBucketPageId(page_idx);
-
-  HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(page_id);
-  Page *page = reinterpret_cast<Page *>(bucket_page);
-  page->RLatch();
-  bool res = bucket_page->GetValue(key, comparator_, result);
-  page->RUnlatch();
-  buffer_pool_manager_->UnpinPage(page_id, false);
-  buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  ReadPageGuard bucket_guard = buffer_pool_manager_->FetchPageRead(page_id);
+  bool res = bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->GetValue(key, comparator_, result);
+  bucket_guard.Drop();
+  dir_guard.Drop();
   table_latch_.RUnlock();
   return res;
 }
@@ -108,25 +101,22 @@ bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
   table_latch_.RLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  BasicPageGuard dir_guard = buffer_pool_manager_->FetchPageBasic(directory_page_id_);
+  const auto *dir_page = dir_guard.As<HashTableDirectoryPage>();
   bool result = false;
   auto page_idx = KeyToDirectoryIndex(key, dir_page);
   auto page_id = dir_page->GetBucketPageId(page_idx);
-  HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(page_id);
-  Page *page = reinterpret_cast<Page *>(bucket_page);
-  page->WLatch();
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(page_id);
   uint32_t bucket_size = 1 << dir_page->GetLocalDepth(page_idx);
-  if (bucket_page->NumReadable() < bucket_size) {
-    result = bucket_page->Insert(key, value, comparator_);
+  if (bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->NumReadable() < bucket_size) {
+    result = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>()->Insert(key, value, comparator_);
     // std::cout << "Insert " << key << " , " << value << "ok,the result is " << result << "\n";
-    page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
-    buffer_pool_manager_->UnpinPage(page_id, true);
+    bucket_guard.Drop();
+    dir_guard.Drop();
     table_latch_.RUnlock();
   } else {
-    page->WUnlatch();
-    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
-    buffer_pool_manager_->UnpinPage(page_id, false);
+    bucket_guard.Drop();
+    dir_guard.Drop();
     table_latch_.RUnlock();
     result = SplitInsert(transaction, key, value);
     // std::cout << "SplitInsert " << key << " , " << value << "ok,the result is " << result << "\n";
@@ -137,59 +127,53 @@ bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) {
   table_latch_.WLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  BasicPageGuard dir_guard = buffer_pool_manager_->FetchPageBasic(directory_page_id_);
+  const auto *dir_page = dir_guard.As<HashTableDirectoryPage>();
   auto page_idx = KeyToDirectoryIndex(key, dir_page);
   auto page_id = dir_page->GetBucketPageId(page_idx);
-  HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(page_id);
-  Page *page_bucket = reinterpret_cast<Page *>(bucket_page);
-  page_bucket->WLatch();
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(page_id);
   uint32_t bucket_size = 1 << dir_page->GetLocalDepth(page_idx);
-  if (bucket_page->NumReadable() < bucket_size) {
+  if (bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->NumReadable() < bucket_size) {
     // LOG_DEBUG("Not need SplitInsert");
-    page_bucket->WUnlatch();
-    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
-    buffer_pool_manager_->UnpinPage(page_id, false);
+    bucket_guard.Drop();
+    dir_guard.Drop();
     table_latch_.WUnlock();
     return Insert(transaction, key, value);
   }
   if (dir_page->GetLocalDepth(page_idx) >= 9) {
-    page_bucket->WUnlatch();
-    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
-    buffer_pool_manager_->UnpinPage(page_id, false);
+    bucket_guard.Drop();
+    dir_guard.Drop();
     table_latch_.WUnlock();
     return false;
   }
-  if (dir_page->GetGlobalDepth() == dir_page->GetLocalDepth(page_idx)) {
-    dir_page->Expand(page_idx);
+  auto *dir_page_mut = dir_guard.AsMut<HashTableDirectoryPage>();
+  if (dir_page_mut->GetGlobalDepth() == dir_page_mut->GetLocalDepth(page_idx)) {
+    dir_page_mut->Expand(page_idx);
   }
   page_id_t new_page_id;
   uint32_t new_mask;
   uint32_t old_mask;
-  auto new_page = buffer_pool_manager_->NewPage(&new_page_id);
-  assert(new_page != nullptr);
-  new_page->WLatch();
-  HASH_TABLE_BUCKET_TYPE *new_bucket = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(new_page);
-  old_mask = dir_page->GetLocalDepthMask(page_idx);
-  dir_page->IncrLocalDepth(page_idx);
-  new_mask = dir_page->GetLocalDepthMask(page_idx);
+  WritePageGuard new_guard = buffer_pool_manager_->NewPageGuarded(&new_page_id, &extent_).UpgradeWrite();
+  assert(new_guard.IsValid());
+  old_mask = dir_page_mut->GetLocalDepthMask(page_idx);
+  dir_page_mut->IncrLocalDepth(page_idx);
+  new_mask = dir_page_mut->GetLocalDepthMask(page_idx);
 
-  for (size_t i = 0; i < dir_page->Size(); i++) {
-    if (i == page_idx || page_id != dir_page->GetBucketPageId(i)) {
+  for (size_t i = 0; i < dir_page_mut->Size(); i++) {
+    if (i == page_idx || page_id != dir_page_mut->GetBucketPageId(i)) {
       continue;
     }
-    dir_page->IncrLocalDepth(i);
+    dir_page_mut->IncrLocalDepth(i);
     auto old_page_idx = old_mask & page_idx;
     auto new_page_idx = new_mask & page_idx;
     if ((old_mask & i) == old_page_idx && (new_mask & i) != new_page_idx) {
-      dir_page->SetBucketPageId(i, new_page_id);
+      dir_page_mut->SetBucketPageId(i, new_page_id);
     }
   }
-  ReHash(page_idx, bucket_page, new_bucket, new_mask);
-  new_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(new_page_id, true);
-  page_bucket->WUnlatch();
-  buffer_pool_manager_->UnpinPage(page_id, true);
-  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
+  ReHash(page_idx, bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>(), new_guard.AsMut<HASH_TABLE_BUCKET_TYPE>(), new_mask);
+  new_guard.Drop();
+  bucket_guard.Drop();
+  dir_guard.Drop();
   table_latch_.WUnlock();
   return Insert(transaction, key, value);
 }
@@ -200,26 +184,18 @@ bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
   table_latch_.RLock();
-  bool result = false;
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
-  auto page_idx = KeyToDirectoryIndex(key, dir_page);
-  auto page_id = dir_page->GetBucketPageId(page_idx);
-  HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(page_id);
-  Page *page_bucket = reinterpret_cast<Page *>(bucket_page);
+  BasicPageGuard dir_guard = buffer_pool_manager_->FetchPageBasic(directory_page_id_);
+  auto page_id = KeyToPageId(key, dir_guard.As<HashTableDirectoryPage>());
+  WritePageGuard bucket_guard = buffer_pool_manager_->FetchPageWrite(page_id);
 
-  page_bucket->WLatch();
-  result = bucket_page->Remove(key, value, comparator_);
-  if (!bucket_page->IsEmpty()) {
-    page_bucket->WUnlatch();
-    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
-    buffer_pool_manager_->UnpinPage(page_id, true);
-    table_latch_.RUnlock();
-  } else {
-    page_bucket->WUnlatch();
-    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
-    buffer_pool_manager_->UnpinPage(page_id, true);
+  auto *bucket_page = bucket_guard.AsMut<HASH_TABLE_BUCKET_TYPE>();
+  bool result = bucket_page->Remove(key, value, comparator_);
+  bool is_empty = bucket_page->IsEmpty();
+  bucket_guard.Drop();
+  dir_guard.Drop();
+  table_latch_.RUnlock();
+  if (is_empty) {
     // LOG_DEBUG("Merge pages because %d",page_id);
-    table_latch_.RUnlock();
     Merge(transaction, key, value);
   }
   return result;
@@ -231,53 +207,51 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
   table_latch_.WLock();
-  HashTableDirectoryPage *dir_page = FetchDirectoryPage();
+  BasicPageGuard dir_guard = buffer_pool_manager_->FetchPageBasic(directory_page_id_);
+  const auto *dir_page = dir_guard.As<HashTableDirectoryPage>();
   auto page_idx = KeyToDirectoryIndex(key, dir_page);
   auto page_id = dir_page->GetBucketPageId(page_idx);
   auto bro_page_idx = dir_page->GetBrother(page_idx);
   auto bro_page_id = dir_page->GetBucketPageId(bro_page_idx);
 
   if (dir_page->GetGlobalDepth() == 0 || dir_page->GetLocalDepth(page_idx) == 0) {
-    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+    dir_guard.Drop();
     table_latch_.WUnlock();
     return;
   }
   if (dir_page->GetLocalDepth(bro_page_idx) != dir_page->GetLocalDepth(page_idx)) {
-    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+    dir_guard.Drop();
     table_latch_.WUnlock();
     return;
   }
-  HASH_TABLE_BUCKET_TYPE *bucket_page = FetchBucketPage(page_id);
-  Page *page_bucket = reinterpret_cast<Page *>(bucket_page);
-  page_bucket->RLatch();
-  if (!bucket_page->IsEmpty()) {
-    page_bucket->RUnlatch();
-    buffer_pool_manager_->UnpinPage(page_id, false);
-    buffer_pool_manager_->UnpinPage(directory_page_id_, false);
+  ReadPageGuard bucket_guard = buffer_pool_manager_->FetchPageRead(page_id);
+  if (!bucket_guard.As<HASH_TABLE_BUCKET_TYPE>()->IsEmpty()) {
+    bucket_guard.Drop();
+    dir_guard.Drop();
     table_latch_.WUnlock();
     return;
   }
-  dir_page->SetBucketPageId(page_idx, bro_page_id);
-  dir_page->DecrLocalDepth(page_idx);
-  dir_page->DecrLocalDepth(bro_page_idx);
+  auto *dir_page_mut = dir_guard.AsMut<HashTableDirectoryPage>();
+  dir_page_mut->SetBucketPageId(page_idx, bro_page_id);
+  dir_page_mut->DecrLocalDepth(page_idx);
+  dir_page_mut->DecrLocalDepth(bro_page_idx);
 
-  page_bucket->RUnlatch();
-  buffer_pool_manager_->UnpinPage(page_id, true);
+  bucket_guard.Drop();
   buffer_pool_manager_->DeletePage(page_id);
 
-  auto local_depth = dir_page->GetLocalDepth(bro_page_idx);
-  for (size_t i = 0; i < dir_page->Size(); i++) {
-    page_id_t tmp_page_id = dir_page->GetBucketPageId(i);
+  auto local_depth = dir_page_mut->GetLocalDepth(bro_page_idx);
+  for (size_t i = 0; i < dir_page_mut->Size(); i++) {
+    page_id_t tmp_page_id = dir_page_mut->GetBucketPageId(i);
     if (tmp_page_id != page_id && tmp_page_id != bro_page_id) {
       continue;
     }
-    dir_page->SetBucketPageId(i, bro_page_id);
-    dir_page->SetLocalDepth(i, local_depth);
+    dir_page_mut->SetBucketPageId(i, bro_page_id);
+    dir_page_mut->SetLocalDepth(i, local_depth);
   }
-  while (dir_page->CanShrink()) {
-    dir_page->DecrGlobalDepth();
+  while (dir_page_mut->CanShrink()) {
+    dir_page_mut->DecrGlobalDepth();
   }
-  buffer_pool_manager_->UnpinPage(directory_page_id_, true);
+  dir_guard.Drop();
   table_latch_.WUnlock();
 }
 
@@ -21,7 +21,14 @@ SeqScanExecutor::~SeqScanExecutor() = default;
 
 void SeqScanExecutor::Init() {
   info_ = exec_ctx_->GetCatalog()->GetTable(plan_->GetTableOid());
-  iterator_ = std::make_shared<TableIterator>(TableIterator(info_->table_->Begin(exec_ctx_->GetTransaction())));
+  // A scan that is initialized again starts over with a new ring; the old iterator must let go of it first.
+  iterator_ = nullptr;
+  strategy_ = nullptr;
+  if (exec_ctx_->GetScanStrategy() == BufferAccessStrategyType::BULK_READ) {
+    strategy_ = std::make_unique<BufferAccessStrategy>(exec_ctx_->GetScanRingSize());
+  }
+  iterator_ = std::make_shared<TableIterator>(
+      TableIterator(info_->table_->Begin(exec_ctx_->GetTransaction(), strategy_.get())));
 }
 
 bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) {
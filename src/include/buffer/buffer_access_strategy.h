@@ -0,0 +1,81 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/** How an executor's scans use the buffer pool. */
+enum class BufferAccessStrategyType {
+  /** Pages go through the replacer like any other. */
+  NORMAL,
+  /** Pages cycle through a small private ring of frames, see BufferAccessStrategy. */
+  BULK_READ,
+};
+
+/**
+ * BufferAccessStrategy confines a bulk read, such as a sequential scan of a large table, to a small ring of frames.
+ * A miss reuses the frame the scan filled ring-size misses ago instead of evicting a page from the rest of the pool,
+ * and the scan's fetches do not count as accesses for the replacement policy. A scan over a table much larger than
+ * the pool then leaves the pool's working set in place.
+ *
+ * Each instance of a parallel buffer pool gets its own ring, of an equal share of the ring size. A strategy belongs to
+ * a single scan and is not thread-safe.
+ */
+class BufferAccessStrategy {
+ public:
+  /** One frame of the ring, and the page the scan read into it. */
+  struct Slot {
+    /** The frame, or -1 if the slot was not used yet. */
+    frame_id_t frame_id_{-1};
+    page_id_t page_id_{INVALID_PAGE_ID};
+  };
+
+  /** Default number of frames in the ring. */
+  static constexpr size_t DEFAULT_RING_SIZE = 64;
+
+  /**
+   * Create a strategy with an empty ring.
+   * @param ring_size the number of frames the scan may occupy
+   */
+  explicit BufferAccessStrategy(size_t ring_size = DEFAULT_RING_SIZE) : ring_size_(ring_size) {}
+
+  DISALLOW_COPY_AND_MOVE(BufferAccessStrategy);
+
+  /** @return the number of frames the scan may occupy */
+  size_t GetRingSize() const { return ring_size_; }
+
+  /**
+   * Advance the ring of a buffer pool instance to the slot for its next miss.
+   * @param instance_index index of the instance in the parallel buffer pool, 0 if there is only one
+   * @param num_instances number of instances in the parallel buffer pool
+   * @return the slot; the miss may reuse its frame, and must store the frame it ends up using in it
+   */
+  Slot *NextSlot(uint32_t instance_index, uint32_t num_instances);
+
+ private:
+  struct Ring {
+    std::vector<Slot> slots_;
+    size_t next_{0};
+  };
+
+  size_t ring_size_;
+  /** One ring per buffer pool instance, created on the first miss in that instance. */
+  std::vector<Ring> rings_;
+};
+
+}  // namespace bustub
@@ -15,11 +15,16 @@
 #include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_metrics.h"
+#include "buffer/extent_allocator.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -84,9 +89,115 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Ask for a page to be read into the buffer pool in the background. The page is not pinned, so this is only a hint:
+   * a later FetchPage may still have to read it, e.g. if it was evicted again in the meantime.
+   * @param page_id id of page to be prefetched
+   */
+  void PrefetchPage(page_id_t page_id) { PrefetchPgImp(page_id); }
+
+  /**
+   * Fetch several pages at once, e.g. the pages of a list of RIDs. Compared to calling FetchPage for each of them, a
+   * buffer pool can look up the misses under one latch acquisition and read them from disk together.
+   * @param page_ids ids of the pages to be fetched
+   * @param num_pages number of pages to be fetched
+   * @param[out] pages the fetched pages, in the order of page_ids; nullptr where a page could not be fetched because
+   * all pages are pinned. Every page that was fetched must be unpinned as usual.
+   */
+  void FetchPages(const page_id_t *page_ids, size_t num_pages, Page **pages) {
+    FetchPgsImp(page_ids, num_pages, pages);
+  }
+
+  /**
+   * Fetch a page on behalf of a bulk read. A miss reuses a frame of the strategy's ring rather than one from the rest
+   * of the pool, and neither hits nor misses count as accesses for the replacement policy.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring of the bulk read
+   * @return the requested page, nullptr if all pages are pinned
+   */
+  Page *FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) {
+    return FetchPgStrategyImp(page_id, strategy);
+  }
+
+  /**
+   * Fetch a page and wrap it in a guard that unpins it when it goes out of scope.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring of a bulk read, see FetchPageWithStrategy, or nullptr for a regular fetch
+   * @return a guard holding a pin on the page, empty if all pages are pinned
+   */
+  BasicPageGuard FetchPageBasic(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) {
+    return {this, strategy == nullptr ? FetchPgImp(page_id) : FetchPgStrategyImp(page_id, strategy)};
+  }
+
+  /**
+   * Fetch a page and take its read latch. Both are released when the guard goes out of scope.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring of a bulk read, see FetchPageWithStrategy, or nullptr for a regular fetch
+   * @return a guard holding a pin and the read latch on the page, empty if all pages are pinned
+   */
+  ReadPageGuard FetchPageRead(page_id_t page_id, BufferAccessStrategy *strategy = nullptr) {
+    return FetchPageBasic(page_id, strategy).UpgradeRead();
+  }
+
+  /**
+   * Fetch a page and take its write latch. Both are released when the guard goes out of scope.
+   * @param page_id id of page to be fetched
+   * @return a guard holding a pin and the write latch on the page, empty if all pages are pinned
+   */
+  WritePageGuard FetchPageWrite(page_id_t page_id) { return FetchPageBasic(page_id).UpgradeWrite(); }
+
+  /**
+   * Create a new page with the next page id of an extent allocator, so that the pages of one table heap or index are
+   * laid out next to each other on disk.
+   * @param[out] page_id id of created page
+   * @param extent the extent allocator of the table heap or index
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageInExtent(page_id_t *page_id, ExtentAllocator *extent) { return NewPgExtentImp(page_id, extent); }
+
+  /**
+   * Create a new page and wrap it in a guard that unpins it when it goes out of scope.
+   * @param[out] page_id id of created page
+   * @param extent the extent allocator to take the page id from, see NewPageInExtent, or nullptr for a regular page
+   * @return a guard holding a pin on the new page, empty if no new page could be created
+   */
+  BasicPageGuard NewPageGuarded(page_id_t *page_id, ExtentAllocator *extent = nullptr) {
+    return {this, extent == nullptr ? NewPgImp(page_id) : NewPgExtentImp(page_id, extent)};
+  }
+
+  /**
+   * Unpin a page through the frame that holds it, which saves the page table lookup of UnpinPage. The caller must
+   * hold a pin on the page, so the frame cannot have been given to another page in the meantime.
+   * @param page the pinned page
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  bool UnpinFrame(Page *page, bool is_dirty) { return UnpinFrameImp(page, is_dirty); }
+
+  /**
+   * Ask for several pages to be read into the buffer pool in the background, see PrefetchPage.
+   * @param page_ids ids of pages to be prefetched
+   */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids) {
+    for (page_id_t page_id : page_ids) {
+      PrefetchPgImp(page_id);
+    }
+  }
+
+  /**
+   * Forget all pages of a segment without writing them back, before the disk manager truncates or drops it. The pages
+   * are not deallocated; their space goes with the segment file.
+   * @param segment_id the segment
+   * @return false if a page of the segment is pinned and stays in the pool, true otherwise
+   */
+  bool DiscardSegment(segment_id_t segment_id) { return DiscardSegmentImp(segment_id); }
+
   /** @return size of the buffer pool */
   virtual size_t GetPoolSize() = 0;
 
+  /** @return a snapshot of the buffer pool's counters. Buffer pools that keep no counters return all zeroes. */
+  virtual BufferPoolMetrics GetMetrics() { return {}; }
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -130,6 +241,14 @@ class BufferPoolManager {
    */
   virtual Page *NewPgImp(page_id_t *page_id) = 0;
 
+  /**
+   * Creates a new page with a page id of an extent. Buffer pools that do not place pages create a regular one.
+   * @param[out] page_id id of created page
+   * @param extent the extent allocator to take the page id from
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual Page *NewPgExtentImp(page_id_t *page_id, ExtentAllocator *extent) { return NewPgImp(page_id); }
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -141,5 +260,46 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Schedule an asynchronous read of a page that is not resident. Buffer pools without background I/O ignore it.
+   * @param page_id id of page to be prefetched
+   */
+  virtual void PrefetchPgImp(page_id_t page_id) {}
+
+  /**
+   * Fetch several pages. Buffer pools that cannot batch the look-ups fetch the pages one by one.
+   * @param page_ids ids of the pages to be fetched
+   * @param num_pages number of pages to be fetched
+   * @param[out] pages the fetched pages
+   */
+  virtual void FetchPgsImp(const page_id_t *page_ids, size_t num_pages, Page **pages) {
+    for (size_t i = 0; i < num_pages; i++) {
+      pages[i] = FetchPgImp(page_ids[i]);
+    }
+  }
+
+  /**
+   * Fetch a page for a bulk read. Buffer pools without rings fetch it like any other page.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring of the bulk read
+   * @return the requested page
+   */
+  virtual Page *FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) { return FetchPgImp(page_id); }
+
+  /**
+   * Unpin a pinned page through its frame. Buffer pools that cannot map a page to its frame look it up by id.
+   * @param page the pinned page
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  virtual bool UnpinFrameImp(Page *page, bool is_dirty) { return UnpinPgImp(page->GetPageId(), is_dirty); }
+
+  /**
+   * Drop the pages of a segment. Buffer pools that hold no pages of their own have nothing to drop.
+   * @param segment_id the segment
+   * @return false if a page of the segment is pinned
+   */
+  virtual bool DiscardSegmentImp(segment_id_t segment_id) { return true; }
 };
 }  // namespace bustub
@@ -12,11 +12,19 @@
 
 #pragma once
 
-#include <list>
-#include <mutex>  // NOLINT
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <mutex>               // NOLINT
+#include <thread>              // NOLINT
 #include <unordered_map>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/frame_arena.h"
+#include "buffer/free_frame_stack.h"
+#include "buffer/lru_k_replacer.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
@@ -34,8 +42,16 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param pool_size the size of the buffer pool
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the replacement policy; the default, CLOCK, lets hits pin and unpin frames without a latch
+   * @param huge_page_mode whether to back the frames with huge pages
+   * @param prefault whether to fault in the memory of every frame at construction
+   * @param max_pool_size the size the pool can grow to with Resize, 0 for pool_size
+   * @param compressed_cache_size bytes of compressed evicted pages to keep in a CompressedPageCache, 0 for none
    */
-  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr);
+  BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerPolicy replacer_policy = ReplacerPolicy::CLOCK,
+                            HugePageMode huge_page_mode = HugePageMode::NONE, bool prefault = false,
+                            size_t max_pool_size = 0, size_t compressed_cache_size = 0);
   /**
    * Creates a new BufferPoolManagerInstance.
    * @param pool_size the size of the buffer pool
@@ -43,9 +59,17 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param instance_index index of this BPI in the parallel BPM
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the replacement policy; the default, CLOCK, lets hits pin and unpin frames without a latch
+   * @param huge_page_mode whether to back the frames with huge pages
+   * @param prefault whether to fault in the memory of every frame at construction
+   * @param max_pool_size the size the pool can grow to with Resize, 0 for pool_size
+   * @param compressed_cache_size bytes of compressed evicted pages to keep in a CompressedPageCache, 0 for none
    */
   BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
-                            DiskManager *disk_manager, LogManager *log_manager = nullptr);
+                            DiskManager *disk_manager, LogManager *log_manager = nullptr,
+                            ReplacerPolicy replacer_policy = ReplacerPolicy::CLOCK,
+                            HugePageMode huge_page_mode = HugePageMode::NONE, bool prefault = false,
+                            size_t max_pool_size = 0, size_t compressed_cache_size = 0);
 
   /**
    * Destroys an existing BufferPoolManagerInstance.
@@ -55,9 +79,66 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() override { return pool_size_; }
 
+  /** @return the size the buffer pool can grow to */
+  size_t GetMaxPoolSize() const { return max_pool_size_; }
+
+  /**
+   * Grow or shrink the buffer pool while it is in use. Growing hands the extra frames to the free list. Shrinking
+   * evicts the pages in the frames past the new size, writing back dirty ones, and returns their memory to the kernel;
+   * pages in the remaining frames stay cached. Pinned pages cannot be evicted, so shrinking waits for them to be
+   * unpinned: the caller must not hold pins on this pool.
+   * @param pool_size the new size, between 1 and GetMaxPoolSize()
+   * @return false if the size is out of range
+   */
+  bool Resize(size_t pool_size);
+
+  /**
+   * Write back all dirty pages like FlushAllPages, without syncing the db file afterwards. For callers that write back
+   * several instances and sync once.
+   */
+  void WriteBackAllPages();
+
+  /**
+   * Create a new page with a given id instead of one from AllocatePage, for a parallel pool that places a page of an
+   * extent in the instance its id belongs to. The id must be fresh, e.g. from ExtentAllocator::Allocate. If a prefetch
+   * already read the page in, as zeros, the new page takes over its frame.
+   * @param page_id id of the page, which must belong to this instance
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPageAt(page_id_t page_id);
+
   /** @return pointer to all the pages in the buffer pool */
   Page *GetPages() { return pages_; }
 
+  /** @return number of frames that hold no page */
+  size_t GetFreeFrameCount() const { return free_list_.Size(); }
+
+  /** @return number of frames that hold an unpinned page and can be evicted */
+  size_t GetEvictableFrameCount() const { return replacer_->Size(); }
+
+  /** @return number of frames that are pinned, including frames whose page is still being read in */
+  size_t GetPinnedFrameCount() const { return num_pinned_frames_; }
+
+  /**
+   * Start a background thread that writes back dirty, unpinned pages that are close to being evicted, so that
+   * FetchPage and NewPage find clean victims. Does nothing if the cleaner is already running.
+   * @param target_clean_ratio fraction of the pool, counted from the next victim onwards, that the cleaner keeps clean
+   * @param max_writes_per_second upper bound on the number of pages the cleaner writes per second
+   */
+  void StartPageCleaner(double target_clean_ratio, size_t max_writes_per_second);
+
+  /** Stop and join the page cleaner thread. Does nothing if it is not running. */
+  void StopPageCleaner();
+
+  /** @return number of dirty victims written back by FetchPage and NewPage */
+  uint64_t GetForegroundWritebackCount() const { return foreground_writebacks_; }
+
+  /** @return number of dirty pages written back by the page cleaner */
+  uint64_t GetBackgroundWritebackCount() const { return background_writebacks_; }
+
+  /** @return a snapshot of this instance's counters */
+  BufferPoolMetrics GetMetrics() override;
+
  protected:
   /**
    * Fetch the requested page from the buffer pool.
@@ -88,6 +169,15 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page with the next id of an extent. An instance of a parallel pool only holds every n-th page id,
+   * so it creates a regular page; the parallel pool places pages of extents itself.
+   * @param[out] page_id id of created page
+   * @param extent the extent allocator to take the page id from
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *NewPgExtentImp(page_id_t *page_id, ExtentAllocator *extent) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -96,23 +186,109 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   bool DeletePgImp(page_id_t page_id) override;
 
   /**
-   * Flushes all the pages in the buffer pool to disk.
+   * Flushes all the dirty pages in the buffer pool to disk. The pages are written in page id order, FLUSH_BATCH_PAGES
+   * at a time, and consecutive pages go to the disk manager as one vectored write; the writes of a batch are in flight
+   * together. Only copying a page out takes its frame latch, so fetches go on while the writes are in flight.
+   * Finally the db file is synced, if the durability mode of the disk manager asks for it on checkpoints.
    */
   void FlushAllPgsImp() override;
 
   /**
-   * Allocate a page on disk.∂
-   * @return the id of the allocated page
+   * Queue a page for the prefetch thread, which reads it in and leaves it unpinned. Starts the thread on first use.
+   * The thread reads queued pages in batches of up to PREFETCH_BATCH_PAGES, like FetchPages does, taking at most half
+   * of the unpinned frames at a time. Resident pages are skipped, and requests are dropped while pool_size_ of them are
+   * already queued.
+   * @param page_id id of page to be prefetched
+   */
+  void PrefetchPgImp(page_id_t page_id) override;
+
+  /**
+   * Fetch several pages. Resident pages are pinned first; the misses then find their frames under a single
+   * acquisition of latch_, and are read from disk in page id order, consecutive pages with one asynchronous read and
+   * all reads in flight together.
+   * @param page_ids ids of the pages to be fetched
+   * @param num_pages number of pages to be fetched
+   * @param[out] pages the fetched pages
+   */
+  void FetchPgsImp(const page_id_t *page_ids, size_t num_pages, Page **pages) override;
+
+  /**
+   * Fetch a page for a bulk read, without recording an access in the replacer. A miss takes the frame from the
+   * strategy's ring if it can, see FindRingFrame.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring of the bulk read
+   * @return the requested page
+   */
+  Page *FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Unpin a pinned page through its frame, without looking it up in the page table.
+   * @param page the pinned page, which must be one of pages_
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  bool UnpinFrameImp(Page *page, bool is_dirty) override;
+
+  /**
+   * Drop the resident pages of a segment like DeletePgImp does, without deallocating them, and wait for write-backs of
+   * evicted ones, so that none of them lands in the segment file after it is truncated or dropped.
+   * @param segment_id the segment
+   * @return false if a page of the segment is pinned
+   */
+  bool DiscardSegmentImp(segment_id_t segment_id) override;
+
+  /**
+   * Take an unpinned page out of the pool, with no write-back, and wait for write-backs of it that are in flight.
+   * @param page_id id of the page
+   * @return false if the page is pinned
+   */
+  bool RemovePage(page_id_t page_id);
+
+  /**
+   * Drop a pin on a frame. Caller must hold the frame latch.
+   * @return false if the frame was not pinned
+   */
+  bool UnpinFrameLocked(frame_id_t frame_id, bool is_dirty);
+
+  /**
+   * Fetch a page, reading it in on a miss.
+   * @param page_id id of page to be fetched
+   * @param record_access whether to report the fetch to the replacer as an access
+   * @param strategy the ring of a bulk read to take the frame from on a miss, or nullptr
+   * @return the requested page, nullptr if all pages are pinned
+   */
+  Page *FetchFrame(page_id_t page_id, bool record_access, BufferAccessStrategy *strategy = nullptr);
+
+  /**
+   * Fetch several pages, see FetchPgsImp.
+   * @param page_ids ids of the pages to be fetched
+   * @param num_pages number of pages to be fetched
+   * @param[out] pages the fetched pages, nullptr for those that found no frame
+   * @param record_access whether to report the fetches to the replacer as accesses, and count them in the metrics
+   */
+  void FetchFrames(const page_id_t *page_ids, size_t num_pages, Page **pages, bool record_access);
+
+  /**
+   * Create a new page in a free frame or in the frame of a victim.
+   * @param[in,out] page_id id of the page; set to a newly allocated one if allocate is true
+   * @param allocate whether to allocate the id with AllocatePage
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  Page *CreatePage(page_id_t *page_id, bool allocate);
+
+  /**
+   * Allocate a page on disk. Deleted pages of this instance are reused, lowest id first, before the file grows. Ids
+   * that the disk manager gave to an extent are skipped. Caller must hold latch_.
+   * @return the id of the allocated page, or INVALID_PAGE_ID if the main segment has no id left
    */
   page_id_t AllocatePage();
 
   /**
-   * Deallocate a page on disk.
+   * Deallocate a page on disk, so that AllocatePage can hand out its id again. Caller must make sure that no write-back
+   * of the page is in flight any more.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
 
   /**
    * Validate that the page_id being used is accessible to this BPI. This can be used in all of the functions to
@@ -120,12 +296,163 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param page_id
    */
   void ValidatePageId(page_id_t page_id) const;
-  void ResetPage(const frame_id_t &frame_id);
-  bool FindFreePage(frame_id_t *frame_id);
+  /**
+   * The page an evicted frame still holds. Its data has to be retired before the frame is reused: written back if it
+   * is dirty, and handed to the compressed cache if there is one. Until then the page is in writeback_pages_.
+   */
+  struct Victim {
+    /** The page, INVALID_PAGE_ID if there is nothing to retire */
+    page_id_t page_id_{INVALID_PAGE_ID};
+    /** Whether the page has to be written back */
+    bool dirty_{false};
+  };
+
+  /**
+   * Pick a frame for a new resident page, from the free list first and then from the replacer. Caller must hold latch_.
+   * @param[out] frame_id the frame that was found
+   * @param[out] victim the page the frame still holds, see Victim
+   * @return false if every frame is pinned
+   */
+  bool FindFreePage(frame_id_t *frame_id, Victim *victim);
+
+  /**
+   * Pick a frame for a bulk read's miss. The frame in the ring slot is reused if it still holds the page the bulk read
+   * put there and nobody has it pinned; otherwise this falls back to FindFreePage. Caller must hold latch_.
+   * @param slot the ring slot of this miss
+   * @param[out] frame_id the frame that was found
+   * @param[out] victim see FindFreePage
+   * @return false if every frame is pinned
+   */
+  bool FindRingFrame(const BufferAccessStrategy::Slot &slot, frame_id_t *frame_id, Victim *victim);
   bool HavePage(page_id_t page_id);
 
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
+  /**
+   * Try to take the frame holding a victim page away from it. The frame is only claimed if nobody pinned it between
+   * the replacer choosing it and now. Caller must hold latch_.
+   * @param frame_id the frame chosen by the replacer
+   * @param[out] victim the victim page, if it has to be retired; the caller must StartWriteback it
+   * @return true if the frame is now unreachable and can be reused, false if it was pinned again in the meantime
+   */
+  bool EvictFrame(frame_id_t frame_id, Victim *victim);
+
+  /**
+   * Pin a page if it is already resident. This only takes the page table stripe and frame latch. The page may still
+   * be in the middle of being read in; use WaitForIo before touching its data.
+   * @param page_id id of the page to pin
+   * @param[out] frame_id the frame holding the page
+   * @param record_access whether to report the pin to the replacer as an access
+   * @return true if the page was found and pinned
+   */
+  bool PinFrame(page_id_t page_id, frame_id_t *frame_id, bool record_access);
+
+  /**
+   * Put a frame found by FindFreePage into the page table for page_id, pinned once and marked as I/O in progress.
+   * Caller must hold latch_.
+   * @param is_new whether the page is a new one, which the disk has no copy of yet
+   */
+  void PublishFrame(frame_id_t frame_id, page_id_t page_id, bool record_access, bool is_new);
+
+  /**
+   * Fill a frame published by PublishFrame. Runs without latch_: retires the frame's previous page if there is one,
+   * reads page_id from the compressed cache or from disk (or zeroes the frame for a new page), then wakes up threads
+   * waiting on the frame.
+   */
+  void LoadFrame(frame_id_t frame_id, page_id_t page_id, const Victim &victim, bool read_from_disk);
+
+  /**
+   * First step of LoadFrame: retire the victim still in the frame, if there is one, and point the frame back at its own
+   * memory.
+   */
+  void RetireVictim(frame_id_t frame_id, const Victim &victim);
+
+  /**
+   * Take a page out of the compressed cache, if there is one.
+   * @return true if the page was there and is now in page_data
+   */
+  bool ReadFromCompressedCache(page_id_t page_id, char *page_data);
+
+  /**
+   * Serve a miss from the read-only mapping of the db file, if there is one: point the frame at the mapped page instead
+   * of reading it. Page::WLatch copies it into the frame when it is to be modified.
+   * @return false if the page is not mapped and has to be read
+   */
+  bool ServeFromMapping(frame_id_t frame_id, page_id_t page_id);
+
+  /** Last step of LoadFrame: mark the frame's I/O as done and wake up the threads waiting for it. */
+  void FinishLoad(frame_id_t frame_id);
+
+  /** Take latch_, adding the time spent blocked on it to the latch wait counter. */
+  std::unique_lock<std::mutex> LockLatch();
+
+  /** Block until the I/O that fills the frame has finished. The caller must have the frame pinned. */
+  void WaitForIo(frame_id_t frame_id);
+
+  /** @return true if a write-back of page_id is in flight */
+  bool HasWriteback(page_id_t page_id);
+
+  /** Record a write-back of page_id in writeback_pages_ before the write is issued. */
+  void StartWriteback(page_id_t page_id);
+
+  /** Block until at most num_own write-backs of page_id, the caller's own ones, are still in flight. */
+  void WaitForWritebacks(page_id_t page_id, size_t num_own);
+
+  /** Drop one in-flight write-back of page_id from writeback_pages_ and wake up anyone waiting for it. */
+  void FinishWriteback(page_id_t page_id);
+
+  /** Body of the prefetch thread. */
+  void RunPrefetcher();
+
+  /** Stop and join the prefetch thread, dropping queued requests. Does nothing if it is not running. */
+  void StopPrefetcher();
+
+  /** Body of the page cleaner thread. */
+  void RunPageCleaner();
+
+  /**
+   * One page cleaner round: write back dirty, unpinned pages among the next victims of the replacer.
+   * @param max_writes the maximum number of pages to write in this round
+   * @return the number of pages written
+   */
+  size_t CleanVictims(size_t max_writes);
+
+  /** How long Resize waits before trying again to evict pinned pages. */
+  static constexpr std::chrono::milliseconds RESIZE_RETRY_INTERVAL{1};
+
+  /** How many pages FlushAllPgsImp copies out and writes at a time. Bounds the memory of the copies. */
+  static constexpr size_t FLUSH_BATCH_PAGES = 256;
+
+  /** How many queued pages the prefetch thread reads at a time. */
+  static constexpr size_t PREFETCH_BATCH_PAGES = 32;
+
+  /** How long the page cleaner sleeps between rounds. */
+  static constexpr std::chrono::milliseconds PAGE_CLEANER_INTERVAL{10};
+
+  /** Number of accesses the LRU-K policy keeps per frame. */
+  static constexpr size_t LRU_K = 2;
+
+  /** Number of partitions of the page table, each protected by its own latch. */
+  static constexpr size_t PAGE_TABLE_STRIPES = 64;
+
+  /** One partition of the page table. Padded to a cache line so that neighbouring stripe latches do not contend. */
+  struct alignas(64) PageTableStripe {
+    std::mutex latch_;
+    std::unordered_map<page_id_t, frame_id_t> table_;
+  };
+
+  /** @return the page table stripe responsible for page_id */
+  PageTableStripe &GetStripe(page_id_t page_id) {
+    return page_table_[(static_cast<size_t>(page_id) / num_instances_) % PAGE_TABLE_STRIPES];
+  }
+
+  /**
+   * Number of frames in use. Frames past it are never handed out; Resize evicts any page they still hold. Changes under
+   * latch_.
+   */
+  std::atomic<size_t> pool_size_;
+  /** Number of frames allocated, the limit for pool_size_. */
+  const size_t max_pool_size_;
+  /** Whether to fault in the memory of frames when they come into use. */
+  const bool prefault_;
   /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
   const uint32_t num_instances_ = 1;
   /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
@@ -133,19 +460,81 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** Each BPI maintains its own counter for page_ids to hand out, must ensure they mod back to its instance_index_ */
   std::atomic<page_id_t> next_page_id_ = instance_index_;
 
-  /** Array of buffer pool pages. */
+  /** Data of every frame, PAGE_SIZE-aligned. */
+  FrameArena frame_arena_;
+  /** Array of buffer pool pages. Their data points into frame_arena_. */
   Page *pages_;
+  /** Per-frame latches protecting page_id_, pin_count_, is_dirty_ and io_in_progress_ of the frame. */
+  std::mutex *frame_latches_;
+  /** Per-frame condition variables, signalled when the frame's io_in_progress_ is cleared. */
+  std::condition_variable *frame_io_cvs_;
   /** Pointer to the disk manager. */
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
   /** Pointer to the log manager. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  std::unordered_map<page_id_t, frame_id_t> page_table_;
+  /** Page table for keeping track of buffer pool pages, striped by page id. */
+  PageTableStripe page_table_[PAGE_TABLE_STRIPES];
   /** Replacer to find unpinned pages for replacement. */
   Replacer *replacer_;
-  /** List of free pages. */
-  std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /** Evicted pages, compressed; nullptr if the pool was created without a compressed cache. */
+  CompressedPageCache *compressed_cache_ = nullptr;
+  /** Frames that hold no page. */
+  FreeFrameStack free_list_;
+  /** Number of frames with a non-zero pin count. Changes under the frame latch of the frame being pinned/unpinned. */
+  std::atomic<size_t> num_pinned_frames_{0};
+  /**
+   * Number of write-backs in flight for each page, either of an evicted dirty page or by the page cleaner. A miss on
+   * one of these pages has to wait for the writes, and any other write of the page is ordered after them.
+   */
+  std::unordered_map<page_id_t, size_t> writeback_pages_;
+  /** Protects writeback_pages_. Taken last, after any other latch. */
+  std::mutex writeback_latch_;
+  /** Signalled whenever a write-back in writeback_pages_ finishes. */
+  std::condition_variable writeback_cv_;
+  /**
+   * This latch serializes changes to the page table, i.e. the miss, new page and delete paths. The hit path and Unpin
+   * never take it, and it is never held across disk I/O. Lock order is latch_, then a page table stripe, then a frame
+   * latch.
+   */
   std::mutex latch_;
+  /** Serializes Resize calls. Taken before latch_. */
+  std::mutex resize_latch_;
+
+  /** The page cleaner thread, nullptr if it is not running. */
+  std::thread *cleaner_thread_ = nullptr;
+  /** Set to false to ask the page cleaner to exit. Protected by cleaner_latch_. */
+  bool cleaner_running_ = false;
+  double cleaner_target_clean_ratio_ = 0;
+  size_t cleaner_max_writes_per_second_ = 0;
+  std::mutex cleaner_latch_;
+  std::condition_variable cleaner_cv_;
+  /** The prefetch thread, nullptr until the first PrefetchPage. */
+  std::thread *prefetch_thread_ = nullptr;
+  /** Set to false to ask the prefetch thread to exit. Protected by prefetch_latch_. */
+  bool prefetch_running_ = false;
+  /** Pages waiting to be prefetched. Protected by prefetch_latch_. */
+  std::deque<page_id_t> prefetch_queue_;
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+
+  /** Write-back counters, so the cleaner can be tuned. */
+  std::atomic<uint64_t> foreground_writebacks_{0};
+  std::atomic<uint64_t> background_writebacks_{0};
+
+  /**
+   * Counters behind GetMetrics. They are only statistics, so they are bumped with relaxed increments, and kept on their
+   * own cache lines so that the hit path does not share a line with the latches above.
+   */
+  struct alignas(64) Counters {
+    std::atomic<uint64_t> fetches_{0};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<uint64_t> evictions_{0};
+    std::atomic<uint64_t> pin_failures_{0};
+    std::atomic<uint64_t> latch_wait_ns_{0};
+    std::atomic<uint64_t> compressed_cache_hits_{0};
+    std::atomic<uint64_t> mapped_reads_{0};
+  };
+  Counters counters_;
 };
 }  // namespace bustub
@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_metrics.h
+//
+// Identification: src/include/buffer/buffer_pool_metrics.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * A snapshot of the counters of a buffer pool. The counters are read one at a time while the pool is running, so a
+ * snapshot is not an atomic cut: e.g. hits_ + misses_ may be off from fetches_ by the fetches in flight.
+ */
+struct BufferPoolMetrics {
+  /** FetchPage calls. Prefetches and the buffer pool's own look-ups are not counted. */
+  uint64_t fetches_{0};
+  /** Fetches that found the page resident, or being read in by another thread. */
+  uint64_t hits_{0};
+  /** Fetches that read the page from disk. */
+  uint64_t misses_{0};
+  /** Pages pushed out of the pool to make room for another one. */
+  uint64_t evictions_{0};
+  /** Dirty victims written back by FetchPage and NewPage, on the caller's time. */
+  uint64_t foreground_writebacks_{0};
+  /** Dirty pages written back by the page cleaner. */
+  uint64_t background_writebacks_{0};
+  /**
+   * FetchPage and NewPage calls that failed because every frame was pinned. A parallel pool's NewPage tries every
+   * instance before it fails, and counts one failure for each.
+   */
+  uint64_t pin_failures_{0};
+  /** Total time threads spent blocked on the buffer pool latch, in nanoseconds. */
+  uint64_t latch_wait_ns_{0};
+  /** Misses served from the compressed cache of evicted pages instead of the disk. Included in misses_. */
+  uint64_t compressed_cache_hits_{0};
+  /** Misses served from a read-only mapping of the db file, without a read or a copy. Included in misses_. */
+  uint64_t mapped_reads_{0};
+
+  /** @return fraction of fetches that were hits, 0 if there were none */
+  double HitRatio() const { return fetches_ == 0 ? 0 : static_cast<double>(hits_) / static_cast<double>(fetches_); }
+
+  /** Add the counters of another snapshot, e.g. of another instance of a parallel buffer pool. */
+  BufferPoolMetrics &operator+=(const BufferPoolMetrics &that) {
+    fetches_ += that.fetches_;
+    hits_ += that.hits_;
+    misses_ += that.misses_;
+    evictions_ += that.evictions_;
+    foreground_writebacks_ += that.foreground_writebacks_;
+    background_writebacks_ += that.background_writebacks_;
+    pin_failures_ += that.pin_failures_;
+    latch_wait_ns_ += that.latch_wait_ns_;
+    compressed_cache_hits_ += that.compressed_cache_hits_;
+    mapped_reads_ += that.mapped_reads_;
+    return *this;
+  }
+};
+
+}  // namespace bustub
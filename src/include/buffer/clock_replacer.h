@@ -12,7 +12,7 @@
 
 #pragma once
 
-#include <list>
+#include <atomic>
 #include <mutex>  // NOLINT
 #include <vector>
 
@@ -23,6 +23,11 @@ namespace bustub {
 
 /**
  * ClockReplacer implements the clock replacement policy, which approximates the Least Recently Used policy.
+ *
+ * Each frame has one atomic state byte. Pin and Unpin only exchange that byte and never block, so they do not
+ * serialize hits on different frames. Only Victim and PeekVictims, which move or read the clock hand, take a latch.
+ * The number of evictable frames is kept in NUM_SHARDS counters on cache lines of their own, picked by frame id, so
+ * that threads pinning different frames rarely write to the same line; Size adds them up.
  */
 class ClockReplacer : public Replacer {
  public:
@@ -45,8 +50,39 @@ class ClockReplacer : public Replacer {
 
   size_t Size() override;
 
+  void PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_frames) override;
+
  private:
-  // TODO(student): implement me!
+  /** The frame is not in the replacer, i.e. it is pinned or holds no page. */
+  static constexpr uint8_t NOT_EVICTABLE = 0;
+  /** The frame can be victimized. */
+  static constexpr uint8_t EVICTABLE = 1;
+  /** The frame can be victimized, but was unpinned since the clock hand last passed it. */
+  static constexpr uint8_t EVICTABLE_REFERENCED = 2;
+  /** Number of counters the size is spread over. */
+  static constexpr size_t NUM_SHARDS = 16;
+
+  /** A part of the size, alone on its cache line. */
+  struct alignas(64) SizeShard {
+    /** Frames of the shard that became evictable minus those that stopped being. May be negative for a moment. */
+    std::atomic<int64_t> count_{0};
+  };
+
+  /** @return the counter of the shard of a frame */
+  std::atomic<int64_t> &GetShard(frame_id_t frame_id) { return shards_[frame_id % NUM_SHARDS].count_; }
+
+  const size_t num_pages_;
+  /** State of each frame, indexed by frame id. */
+  std::atomic<uint8_t> *states_;
+  /**
+   * Frames whose state is not NOT_EVICTABLE, counted per shard. The sum may be off by the frames of Pin and Unpin calls
+   * in progress.
+   */
+  SizeShard shards_[NUM_SHARDS];
+  /** Serializes Victim and PeekVictims, which are the only users of clock_hand_. */
+  std::mutex victim_latch_;
+  /** The next frame the clock looks at. */
+  size_t clock_hand_ = 0;
 };
 
 }  // namespace bustub
@@ -0,0 +1,104 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.h
+//
+// Identification: src/include/buffer/compressed_page_cache.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageCache is a second tier below the buffer pool: it keeps pages that were evicted from the pool,
+ * compressed with LzUtil, so that fetching them again costs a decompression instead of a disk read. Every page in the
+ * cache matches its copy on disk; the buffer pool inserts a dirty page only once it is written back.
+ *
+ * The cache is exclusive of the pool: Get hands a page back and forgets it. When the compressed pages exceed the
+ * capacity, the least recently inserted ones are dropped. Pages that do not compress to MAX_COMPRESSED_SIZE are not
+ * worth the memory and are not kept.
+ */
+class CompressedPageCache {
+ public:
+  /** Largest compressed page the cache keeps. */
+  static constexpr size_t MAX_COMPRESSED_SIZE = PAGE_SIZE / 4 * 3;
+
+  /**
+   * Create an empty cache.
+   * @param capacity the number of bytes of compressed pages the cache may hold
+   */
+  explicit CompressedPageCache(size_t capacity) : capacity_(capacity) {}
+
+  DISALLOW_COPY_AND_MOVE(CompressedPageCache);
+
+  /**
+   * Compress a page and keep it, replacing any older copy.
+   * @param page_id id of the page
+   * @param page_data the page, as it is on disk
+   */
+  void Insert(page_id_t page_id, const char *page_data);
+
+  /**
+   * Take a page out of the cache.
+   * @param page_id id of the page
+   * @param[out] page_data the page, if it was in the cache
+   * @return true if the page was in the cache
+   */
+  bool Get(page_id_t page_id, char *page_data);
+
+  /**
+   * Forget a page, e.g. because it was deleted.
+   * @param page_id id of the page
+   */
+  void Erase(page_id_t page_id);
+
+  /**
+   * Forget the pages of a range of ids, e.g. of a dropped segment.
+   * @param first_page_id the lowest id of the range
+   * @param last_page_id the highest id of the range
+   */
+  void EraseRange(page_id_t first_page_id, page_id_t last_page_id);
+
+  /** @return the number of pages in the cache */
+  size_t GetNumPages();
+
+  /** @return the number of bytes of compressed pages in the cache */
+  size_t GetSize();
+
+  /** @return the number of bytes of compressed pages the cache may hold */
+  size_t GetCapacity() const { return capacity_; }
+
+ private:
+  struct Entry {
+    page_id_t page_id_;
+    std::unique_ptr<char[]> data_;
+    size_t size_;
+  };
+
+  /** Drop an entry. Caller must hold latch_. */
+  void EraseLocked(std::unordered_map<page_id_t, std::list<Entry>::iterator>::iterator it);
+
+  const size_t capacity_;
+  /** Entries, the most recently inserted first. */
+  std::list<Entry> entries_;
+  std::unordered_map<page_id_t, std::list<Entry>::iterator> index_;
+  /** Total size of the compressed pages. */
+  size_t size_{0};
+  /** Protects everything above. Compression happens outside of it. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
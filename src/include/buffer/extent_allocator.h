@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extent_allocator.h
+//
+// Identification: src/include/buffer/extent_allocator.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * ExtentAllocator hands out the page ids of one table heap or index from extents: runs of consecutive page ids that
+ * the disk manager reserves for it alone. The pages of the object then sit next to each other in the file, instead of
+ * interleaved with the pages of everything else that grows at the same time, so that scans, read-ahead and coalesced
+ * write-back work on contiguous ranges.
+ *
+ * An extent spans all instances of a parallel buffer pool, so the pool creates each page in the instance that the id
+ * belongs to, see BufferPoolManager::NewPageInExtent. Ids that were handed out but could not be used, because that
+ * instance had no free frame, are given back and handed out first the next time.
+ *
+ * The extents come from one segment of the database, the main one unless the object has a segment file of its own.
+ */
+class ExtentAllocator {
+ public:
+  /** Default number of pages in an extent. */
+  static constexpr size_t DEFAULT_EXTENT_SIZE = 16;
+
+  /**
+   * Create an allocator without an extent. The first one is reserved on the first allocation.
+   * @param extent_size the number of pages in an extent
+   * @param segment_id the segment to reserve the extents in
+   */
+  explicit ExtentAllocator(size_t extent_size = DEFAULT_EXTENT_SIZE,
+                           segment_id_t segment_id = DiskManager::MAIN_SEGMENT)
+      : extent_size_(extent_size), segment_id_(segment_id) {}
+
+  DISALLOW_COPY_AND_MOVE(ExtentAllocator);
+
+  /**
+   * Take the next page id, reserving a new extent if the current one is used up.
+   * @param disk_manager the disk manager to reserve extents from
+   * @return the page id
+   */
+  page_id_t Allocate(DiskManager *disk_manager);
+
+  /**
+   * Give back a page id that Allocate handed out, because no page could be created with it.
+   * @param page_id the page id
+   */
+  void Return(page_id_t page_id);
+
+  /** Forget the current extent and the ids given back, e.g. after the segment was truncated. */
+  void Reset();
+
+  /** @return the number of pages in an extent */
+  size_t GetExtentSize() const { return extent_size_; }
+
+  /** @return the number of extents reserved so far */
+  size_t GetNumExtents();
+
+  /** @return the segment the extents are reserved in */
+  segment_id_t GetSegmentId() const { return segment_id_; }
+
+ private:
+  const size_t extent_size_;
+  const segment_id_t segment_id_;
+  /** Next unused id of the current extent, and the end of it. Both INVALID_PAGE_ID before the first extent. */
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  page_id_t end_page_id_{INVALID_PAGE_ID};
+  /** Ids that were given back. */
+  std::vector<page_id_t> returned_;
+  size_t num_extents_{0};
+  /** Protects everything above; an allocator is shared by all writers of its table heap or index. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/** How the frame arena is backed by huge pages. */
+enum class HugePageMode {
+  /** Regular pages only. */
+  NONE,
+  /** Ask the kernel for transparent huge pages. */
+  TRANSPARENT,
+  /** Use explicitly reserved huge pages (MAP_HUGETLB), falling back to transparent huge pages if none are free. */
+  EXPLICIT,
+};
+
+/**
+ * FrameArena is one contiguous, anonymous memory mapping that holds the data of every frame of a buffer pool. Each
+ * frame starts on a PAGE_SIZE boundary, which direct I/O requires, and the whole arena can be backed by huge pages to
+ * cut down on TLB misses in large pools.
+ */
+class FrameArena {
+ public:
+  /** Size of a huge page, and the alignment of the arena when huge pages are requested. */
+  static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+  /**
+   * Map the arena. Throws an OUT_OF_MEMORY exception if the mapping fails.
+   * @param num_frames the number of frames in the arena
+   * @param huge_page_mode whether to back the arena with huge pages
+   * @param prefault whether to touch every page now, instead of taking the page faults on first use
+   */
+  FrameArena(size_t num_frames, HugePageMode huge_page_mode, bool prefault);
+
+  /** Unmap the arena. */
+  ~FrameArena();
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @return the data of a frame, PAGE_SIZE bytes, zeroed until first written */
+  char *GetFrameData(frame_id_t frame_id) { return data_ + static_cast<size_t>(frame_id) * PAGE_SIZE; }
+
+  /**
+   * Touch the memory of a range of frames so that it is backed now.
+   * @param first_frame the first frame of the range
+   * @param num_frames the number of frames in the range
+   */
+  void Prefault(size_t first_frame, size_t num_frames);
+
+  /**
+   * Hand the memory of a range of frames back to the kernel. The mapping stays, and released frames read as zeroes
+   * until they are written again. Best effort: with explicit huge pages only the whole huge pages in the range are
+   * released, the rest is left as it is.
+   * @param first_frame the first frame of the range
+   * @param num_frames the number of frames in the range
+   */
+  void Release(size_t first_frame, size_t num_frames);
+
+  /** @return true if the arena was mapped with MAP_HUGETLB */
+  bool UsesExplicitHugePages() const { return explicit_huge_pages_; }
+
+ private:
+  /** Start of the mapping. */
+  char *data_ = nullptr;
+  /** Length of the mapping, a multiple of HUGE_PAGE_SIZE if huge pages were requested. */
+  size_t size_ = 0;
+  bool explicit_huge_pages_ = false;
+};
+
+}  // namespace bustub
@@ -0,0 +1,69 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_frame_stack.h
+//
+// Identification: src/include/buffer/free_frame_stack.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FreeFrameStack is a lock-free stack of the frame ids that currently hold no page. Every frame has a fixed slot for
+ * its next pointer, so Push and Pop never allocate. The head carries a version tag to rule out ABA.
+ */
+class FreeFrameStack {
+ public:
+  /**
+   * Create a new FreeFrameStack holding every frame id in [0, num_frames). Frame 0 is popped first.
+   * @param num_frames the number of frames in the buffer pool
+   */
+  explicit FreeFrameStack(size_t num_frames);
+
+  /**
+   * Destroys the FreeFrameStack.
+   */
+  ~FreeFrameStack();
+
+  DISALLOW_COPY_AND_MOVE(FreeFrameStack);
+
+  /**
+   * Push a frame that no longer holds a page.
+   * @param frame_id the id of the frame, which must not already be in the stack
+   */
+  void Push(frame_id_t frame_id);
+
+  /**
+   * Pop a free frame.
+   * @param[out] frame_id the id of the popped frame
+   * @return false if there are no free frames
+   */
+  bool Pop(frame_id_t *frame_id);
+
+  /** @return the number of free frames. May briefly over-count while a Push or Pop is in progress. */
+  size_t Size() const { return size_.load(std::memory_order_relaxed); }
+
+ private:
+  /** Frame slot value marking the bottom of the stack. */
+  static constexpr uint32_t EMPTY = UINT32_MAX;
+
+  /** Low 32 bits: frame id on top of the stack (or EMPTY). High 32 bits: version bumped on every change. */
+  std::atomic<uint64_t> head_;
+  /** next_[i] is the frame below frame i while frame i is in the stack. */
+  std::atomic<uint32_t> *next_;
+  std::atomic<size_t> size_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer.h
+//
+// Identification: src/include/buffer/lru_k_replacer.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <mutex>  // NOLINT
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * LRUKReplacer implements the LRU-K replacement policy. It evicts the frame whose K-th most recent access is the
+ * oldest, i.e. the one with the largest backward K-distance. Frames with fewer than K accesses have an infinite
+ * K-distance and go first, the one with the oldest access among them before the others. A page touched once by a
+ * sequential scan therefore never pushes out pages that are used over and over.
+ *
+ * Back-to-back accesses to the same frame, with no access to another frame in between, are correlated: they count as
+ * one, so that a page that is fetched several times in a row while being read does not look hot.
+ */
+class LRUKReplacer : public Replacer {
+ public:
+  /**
+   * Create a new LRUKReplacer.
+   * @param num_pages the maximum number of pages the LRUKReplacer will be required to store
+   * @param k the number of accesses kept per frame
+   */
+  LRUKReplacer(size_t num_pages, size_t k);
+
+  /**
+   * Destroys the LRUKReplacer.
+   */
+  ~LRUKReplacer() override;
+
+  bool Victim(frame_id_t *frame_id) override;
+
+  void Pin(frame_id_t frame_id) override;
+
+  void Unpin(frame_id_t frame_id) override;
+
+  void RecordAccess(frame_id_t frame_id) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  size_t Size() override;
+
+  void PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_frames) override;
+
+ private:
+  struct FrameInfo {
+    /** Timestamps of the last (at most) k accesses, oldest first. */
+    std::deque<uint64_t> history_;
+    /** True if the frame is in cold_frames_ or hot_frames_. */
+    bool evictable_ = false;
+    /** The key the frame is stored under while it is evictable. */
+    uint64_t key_ = 0;
+  };
+
+  /** Put an unpinned frame into cold_frames_ or hot_frames_, depending on its history. */
+  void Insert(frame_id_t frame_id);
+
+  /** Take a frame out of cold_frames_ or hot_frames_. */
+  void Erase(frame_id_t frame_id);
+
+  std::mutex latch_;
+  const size_t k_;
+  /** Logical clock, advanced by every access. */
+  uint64_t current_timestamp_ = 0;
+  /** The frame accessed last, to detect correlated accesses. */
+  frame_id_t last_frame_id_ = -1;
+  std::vector<FrameInfo> frames_;
+  /** Evictable frames with fewer than k accesses, by their oldest access. */
+  std::set<std::pair<uint64_t, frame_id_t>> cold_frames_;
+  /** Evictable frames with k accesses, by their k-th most recent access. */
+  std::set<std::pair<uint64_t, frame_id_t>> hot_frames_;
+};
+
+}  // namespace bustub
@@ -15,6 +15,7 @@
 #include <list>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/replacer.h"
 #include "common/config.h"
@@ -46,6 +47,8 @@ class LRUReplacer : public Replacer {
 
   size_t Size() override;
 
+  void PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_frames) override;
+
  private:
   // TODO(student): implement me!
   std::mutex latch_;
@@ -11,8 +11,11 @@
 //===----------------------------------------------------------------------===//
 
 #pragma once
+#include <atomic>
+#include <mutex>  // NOLINT
 #include <vector>
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/frame_arena.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
@@ -28,9 +31,16 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    * @param pool_size the pool size of each BufferPoolManagerInstance
    * @param disk_manager the disk manager
    * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_policy the replacement policy of every BufferPoolManagerInstance, CLOCK by default
+   * @param huge_page_mode whether to back the frames of every BufferPoolManagerInstance with huge pages
+   * @param prefault whether to fault in the memory of every frame at construction
+   * @param max_pool_size the size each BufferPoolManagerInstance can grow to with Resize, 0 for pool_size
+   * @param compressed_cache_size bytes of compressed evicted pages each BufferPoolManagerInstance keeps, 0 for none
    */
   ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerPolicy replacer_policy = ReplacerPolicy::CLOCK,
+                            HugePageMode huge_page_mode = HugePageMode::NONE, bool prefault = false,
+                            size_t max_pool_size = 0, size_t compressed_cache_size = 0);
 
   /**
    * Destroys an existing ParallelBufferPoolManager.
@@ -40,6 +50,17 @@ class ParallelBufferPoolManager : public BufferPoolManager {
   /** @return size of the buffer pool */
   size_t GetPoolSize() override;
 
+  /**
+   * Grow or shrink every BufferPoolManagerInstance while the pool is in use, see BufferPoolManagerInstance::Resize.
+   * The caller must not hold pins on this pool.
+   * @param pool_size the new size of each BufferPoolManagerInstance
+   * @return false if the size is out of range for any instance, which then all keep their old sizes
+   */
+  bool Resize(size_t pool_size);
+
+  /** @return the counters of all BufferPoolManagerInstances, summed up */
+  BufferPoolMetrics GetMetrics() override;
+
  protected:
   /**
    * @param page_id id of page
@@ -76,6 +97,15 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   Page *NewPgImp(page_id_t *page_id) override;
 
+  /**
+   * Creates a new page with the next id of an extent, in the instance the id belongs to. The ids of an extent are
+   * consecutive, so its pages are spread over all instances like any other run of pages.
+   * @param[out] page_id id of created page
+   * @param extent the extent allocator to take the page id from
+   * @return nullptr if the instance of the id has no frame for it, otherwise pointer to new page
+   */
+  Page *NewPgExtentImp(page_id_t *page_id, ExtentAllocator *extent) override;
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -88,12 +118,51 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   void FlushAllPgsImp() override;
 
+  /**
+   * Schedule an asynchronous read of a page on the responsible BufferPoolManagerInstance.
+   * @param page_id id of page to be prefetched
+   */
+  void PrefetchPgImp(page_id_t page_id) override;
+
+  /**
+   * Fetch several pages, with one batch per responsible BufferPoolManagerInstance.
+   * @param page_ids ids of the pages to be fetched
+   * @param num_pages number of pages to be fetched
+   * @param[out] pages the fetched pages
+   */
+  void FetchPgsImp(const page_id_t *page_ids, size_t num_pages, Page **pages) override;
+
+  /**
+   * Fetch a page for a bulk read from the responsible BufferPoolManagerInstance.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring of the bulk read
+   * @return the requested page
+   */
+  Page *FetchPgStrategyImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+  /**
+   * Unpin a pinned page through its frame on the responsible BufferPoolManagerInstance.
+   * @param page the pinned page
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  bool UnpinFrameImp(Page *page, bool is_dirty) override;
+
+  /**
+   * Drop the pages of a segment from all BufferPoolManagerInstances.
+   * @param segment_id the segment
+   * @return false if a page of the segment is pinned in any instance
+   */
+  bool DiscardSegmentImp(segment_id_t segment_id) override;
+
   size_t num_instances_;
-  size_t next_instance_;
-  std::vector<BufferPoolManager *> instances_;
+  /** Ticket counter; NewPage starts looking at instance next_instance_ % num_instances_. Never moves backwards. */
+  std::atomic<size_t> next_instance_;
+  std::vector<BufferPoolManagerInstance *> instances_;
   size_t pool_size_;
   DiskManager *disk_manager_;
   LogManager *log_manager_;
-  std::mutex latch_;
+  /** Serializes Resize, so every instance ends up with the size of the same call. */
+  std::mutex resize_latch_;
 };
 }  // namespace bustub
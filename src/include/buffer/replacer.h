@@ -12,10 +12,15 @@
 
 #pragma once
 
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
+/** Replacement policies a buffer pool can be created with. */
+enum class ReplacerPolicy { LRU, LRU_K, CLOCK };
+
 /**
  * Replacer is an abstract class that tracks page usage.
  */
@@ -43,8 +48,29 @@ class Replacer {
    */
   virtual void Unpin(frame_id_t frame_id) = 0;
 
+  /**
+   * Record an access to the page held by a frame. Called on every fetch, hit or miss, while the frame is pinned.
+   * Policies that only care about the order of Unpin calls can ignore it.
+   * @param frame_id the id of the frame that was accessed
+   */
+  virtual void RecordAccess(frame_id_t frame_id) {}
+
+  /**
+   * Forget a frame because the page it held is gone, e.g. deleted or evicted. The frame cannot be victimized until it
+   * is unpinned again, and any access history kept for it is dropped.
+   * @param frame_id the id of the frame to remove
+   */
+  virtual void Remove(frame_id_t frame_id) { Pin(frame_id); }
+
   /** @return the number of elements in the replacer that can be victimized */
   virtual size_t Size() = 0;
+
+  /**
+   * Look at the frames that would be victimized next without removing them.
+   * @param[out] frame_ids the frames are appended here in the order they would be victimized
+   * @param max_frames the maximum number of frames to look at
+   */
+  virtual void PeekVictims(std::vector<frame_id_t> *frame_ids, size_t max_frames) = 0;
 };
 
 }  // namespace bustub
@@ -0,0 +1,57 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz_util.h
+//
+// Identification: src/include/common/util/lz_util.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+namespace bustub {
+
+/**
+ * LzUtil is a small LZ77 block codec in the spirit of LZ4: a greedy matcher with one hash table probe per position,
+ * and a byte-oriented format that decodes without any state besides the output. It trades ratio for speed, and is
+ * meant for whole pages, e.g. table pages with runs of zeroes or repeated column values.
+ *
+ * A block is a sequence of sequences. Each sequence is a token byte whose high nibble is the literal length and whose
+ * low nibble is the match length minus MIN_MATCH, a nibble of 15 meaning that more length bytes follow (each adding up
+ * to 255); then the literals; then a two byte little-endian offset back into the output. The last sequence of a block
+ * ends after its literals.
+ */
+class LzUtil {
+ public:
+  /** The shortest match the format can express. */
+  static constexpr size_t MIN_MATCH = 4;
+  /** The farthest back a match can reach. */
+  static constexpr size_t MAX_OFFSET = 65535;
+
+  /**
+   * Compress a block.
+   * @param src the data to compress
+   * @param src_len length of src
+   * @param[out] dst the compressed block
+   * @param dst_capacity size of dst
+   * @return length of the compressed block, 0 if it does not fit in dst_capacity bytes
+   */
+  static size_t Compress(const char *src, size_t src_len, char *dst, size_t dst_capacity);
+
+  /**
+   * Decompress a block made by Compress.
+   * @param src the compressed block
+   * @param src_len length of src
+   * @param[out] dst the decompressed data
+   * @param dst_len length of the decompressed data
+   * @return false if the block is corrupt or does not decompress to exactly dst_len bytes
+   */
+  static bool Decompress(const char *src, size_t src_len, char *dst, size_t dst_len);
+};
+
+}  // namespace bustub
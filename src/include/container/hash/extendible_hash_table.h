@@ -39,9 +39,11 @@ class ExtendibleHashTable {
    * @param buffer_pool_manager buffer pool manager to be used
    * @param comparator comparator for keys
    * @param hash_fn the hash function
+   * @param segment_id the segment to put the pages of the table in, see DiskManager::CreateSegment
    */
   explicit ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn);
+                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                               segment_id_t segment_id = DiskManager::MAIN_SEGMENT);
 
   /**
    * Inserts a key-value pair into the hash table.
@@ -109,7 +111,7 @@ class ExtendibleHashTable {
    * @param dir_page to use for lookup of global depth
    * @return the directory index
    */
-  inline uint32_t KeyToDirectoryIndex(KeyType key, HashTableDirectoryPage *dir_page);
+  inline uint32_t KeyToDirectoryIndex(KeyType key, const HashTableDirectoryPage *dir_page);
 
   /**
    * Get the bucket page_id corresponding to a key.
@@ -118,7 +120,7 @@ class ExtendibleHashTable {
    * @param dir_page a pointer to the hash table's directory page
    * @return the bucket page_id corresponding to the input key
    */
-  inline uint32_t KeyToPageId(KeyType key, HashTableDirectoryPage *dir_page);
+  inline uint32_t KeyToPageId(KeyType key, const HashTableDirectoryPage *dir_page);
 
   /**
    * Fetches the directory page from the buffer pool manager.
@@ -127,14 +129,6 @@ class ExtendibleHashTable {
    */
   HashTableDirectoryPage *FetchDirectoryPage();
 
-  /**
-   * Fetches the a bucket page from the buffer pool manager using the bucket's page_id.
-   *
-   * @param bucket_page_id the page_id to fetch
-   * @return a pointer to a bucket page
-   */
-  HASH_TABLE_BUCKET_TYPE *FetchBucketPage(page_id_t bucket_page_id);
-
   /**
    * Performs insertion with an optional bucket splitting.
    *
@@ -168,6 +162,8 @@ class ExtendibleHashTable {
   // Readers includes inserts and removes, writers are splits and merges
   ReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
+  /** Hands out the ids of the directory and bucket pages, so that they are laid out together on disk. */
+  ExtentAllocator extent_;
 };
 
 }  // namespace bustub
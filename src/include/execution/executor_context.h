@@ -16,6 +16,7 @@
 #include <utility>
 #include <vector>
 
+#include "buffer/buffer_access_strategy.h"
 #include "catalog/catalog.h"
 #include "concurrency/transaction.h"
 #include "storage/page/tmp_tuple_page.h"
@@ -60,6 +61,23 @@ class ExecutorContext {
   /** @return the transaction manager */
   TransactionManager *GetTransactionManager() { return txn_mgr_; }
 
+  /**
+   * Choose how the sequential scans of this context use the buffer pool. Takes effect on the next Init of a scan.
+   * @param scan_strategy NORMAL, or BULK_READ to confine each scan to a private ring of frames
+   * @param ring_size the number of frames in the ring of each BULK_READ scan
+   */
+  void SetScanStrategy(BufferAccessStrategyType scan_strategy,
+                       size_t ring_size = BufferAccessStrategy::DEFAULT_RING_SIZE) {
+    scan_strategy_ = scan_strategy;
+    scan_ring_size_ = ring_size;
+  }
+
+  /** @return how the sequential scans of this context use the buffer pool */
+  BufferAccessStrategyType GetScanStrategy() const { return scan_strategy_; }
+
+  /** @return the number of frames in the ring of a BULK_READ scan */
+  size_t GetScanRingSize() const { return scan_ring_size_; }
+
  private:
   /** The transaction context associated with this executor context */
   Transaction *transaction_;
@@ -71,6 +89,10 @@ class ExecutorContext {
   TransactionManager *txn_mgr_;
   /** The lock manager associated with this executor context */
   LockManager *lock_mgr_;
+  /** How sequential scans use the buffer pool */
+  BufferAccessStrategyType scan_strategy_{BufferAccessStrategyType::NORMAL};
+  /** The ring size of BULK_READ scans */
+  size_t scan_ring_size_{BufferAccessStrategy::DEFAULT_RING_SIZE};
 };
 
 }  // namespace bustub
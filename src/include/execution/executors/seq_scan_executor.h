@@ -51,6 +51,8 @@ class SeqScanExecutor : public AbstractExecutor {
  private:
   /** The sequential scan plan node to be executed */
   TableInfo *info_;
+  /** The ring of a BULK_READ scan, nullptr for a NORMAL one. Declared before iterator_, which refers to it. */
+  std::unique_ptr<BufferAccessStrategy> strategy_;
   std::shared_ptr<TableIterator> iterator_;
   const SeqScanPlanNode *plan_;
 };
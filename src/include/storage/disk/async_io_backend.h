@@ -0,0 +1,194 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io_backend.h
+//
+// Identification: src/include/storage/disk/async_io_backend.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <future>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace bustub {
+
+class DiskManager;
+struct SegmentFile;
+
+/** How DiskManager runs asynchronous reads and writes. */
+enum class AsyncIoType {
+  /** io_uring if the kernel lets us set up a ring, a thread pool otherwise. */
+  AUTO,
+  /** io_uring, which keeps many requests in flight without a thread each. */
+  IO_URING,
+  /** A small pool of threads doing regular positional I/O. */
+  THREAD_POOL
+};
+
+/** A read or write of a run of consecutive pages, in flight. */
+struct AsyncIoRequest {
+  bool write_;
+  page_id_t first_page_id_;
+  /** The file of the segment of the pages, held open until the request is done. All pages are in that segment. */
+  std::shared_ptr<SegmentFile> file_;
+  std::vector<char *> page_data_;
+  std::vector<iovec> iovs_;
+  std::promise<void> promise_;
+  /**
+   * Set when the request is handed to the backend and read when it completes. An io_uring completion orders the two,
+   * but only through the kernel, which race detectors cannot see.
+   */
+  std::atomic<bool> submitted_{false};
+};
+
+/**
+ * AsyncIoBackend runs the asynchronous requests of a DiskManager. A request is done, and its promise set, once the
+ * pages are written or read. A write the backend does itself is not synced; under SYNC_EACH_WRITE, the disk manager
+ * syncs it once the write is waited for. A request that a backend cannot finish on its own, e.g. a read past the end
+ * of the file, is finished with the synchronous DiskManager calls, so it behaves the same as ReadPages and WritePages.
+ */
+class AsyncIoBackend {
+ public:
+  /**
+   * Create a backend for the db file of a disk manager.
+   * @param type the backend to create; AUTO and IO_URING fall back to a thread pool if io_uring is not available
+   * @param disk_manager the disk manager to run the requests for
+   * @return the new backend
+   */
+  static AsyncIoBackend *Create(AsyncIoType type, DiskManager *disk_manager);
+
+  /** Wait for all requests in flight and release the backend. */
+  virtual ~AsyncIoBackend() = default;
+
+  DISALLOW_COPY_AND_MOVE(AsyncIoBackend);
+
+  /**
+   * Start a request. The backend takes ownership of it.
+   * @param request the request
+   */
+  virtual void Submit(AsyncIoRequest *request) = 0;
+
+  /** @return the kind of backend, never AUTO */
+  virtual AsyncIoType GetType() const = 0;
+
+ protected:
+  explicit AsyncIoBackend(DiskManager *disk_manager);
+
+  /**
+   * Set the promise of a request and free it.
+   * @param request the request
+   * @param done whether the backend transferred all of the request; if not, the rest is done synchronously
+   */
+  void FinishRequest(AsyncIoRequest *request, bool done);
+
+  DiskManager *disk_manager_;
+};
+
+/**
+ * IoUringBackend submits requests to an io_uring instance, set up with the raw system calls. A reaper thread waits for
+ * the completions. At most as many requests as the submission queue has entries are in flight; Submit blocks beyond
+ * that.
+ */
+class IoUringBackend : public AsyncIoBackend {
+ public:
+  /** Number of submission queue entries. */
+  static constexpr unsigned QUEUE_DEPTH = 128;
+
+  /**
+   * Set up a ring.
+   * @param disk_manager the disk manager to run the requests for
+   * @return the new backend, or nullptr if the kernel does not support io_uring or does not let us use it
+   */
+  static IoUringBackend *Create(DiskManager *disk_manager);
+
+  ~IoUringBackend() override;
+
+  void Submit(AsyncIoRequest *request) override;
+
+  AsyncIoType GetType() const override { return AsyncIoType::IO_URING; }
+
+ private:
+  explicit IoUringBackend(DiskManager *disk_manager) : AsyncIoBackend(disk_manager) {}
+
+  /** Create and map the ring. @return false on failure */
+  bool Setup();
+
+  /** Unmap and close whatever Setup got to. */
+  void Teardown();
+
+  /** Queue an entry and hand it to the kernel. Caller must hold latch_. @return false on failure */
+  bool PushSqe(uint8_t opcode, AsyncIoRequest *request);
+
+  /** Body of the reaper thread. */
+  void RunReaper();
+
+  int ring_fd_{-1};
+  void *sq_ring_{nullptr};
+  size_t sq_ring_size_{0};
+  void *cq_ring_{nullptr};
+  size_t cq_ring_size_{0};
+  io_uring_sqe *sqes_{nullptr};
+  size_t sqes_size_{0};
+  unsigned sq_entries_{0};
+  unsigned *sq_tail_{nullptr};
+  unsigned *sq_mask_{nullptr};
+  unsigned *sq_array_{nullptr};
+  unsigned *cq_head_{nullptr};
+  unsigned *cq_tail_{nullptr};
+  unsigned *cq_mask_{nullptr};
+  io_uring_cqe *cqes_{nullptr};
+  /** Number of submitted requests that have not completed. */
+  size_t in_flight_{0};
+  /** Protects the submission queue and in_flight_. */
+  std::mutex latch_;
+  /** Signalled when requests complete. */
+  std::condition_variable cv_;
+  std::thread *reaper_{nullptr};
+};
+
+/** ThreadPoolIoBackend runs requests on a few threads with the synchronous DiskManager calls. */
+class ThreadPoolIoBackend : public AsyncIoBackend {
+ public:
+  /** Number of worker threads, i.e. of requests in flight. */
+  static constexpr size_t NUM_THREADS = 4;
+
+  explicit ThreadPoolIoBackend(DiskManager *disk_manager);
+
+  ~ThreadPoolIoBackend() override;
+
+  void Submit(AsyncIoRequest *request) override;
+
+  AsyncIoType GetType() const override { return AsyncIoType::THREAD_POOL; }
+
+ private:
+  /** Body of a worker thread. */
+  void RunWorker();
+
+  std::deque<AsyncIoRequest *> queue_;
+  bool running_{true};
+  /** Protects queue_ and running_. */
+  std::mutex latch_;
+  std::condition_variable cv_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace bustub
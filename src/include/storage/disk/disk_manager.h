@@ -12,29 +12,166 @@
 
 #pragma once
 
+#include <sys/types.h>
+
+#include <algorithm>
 #include <atomic>
+#include <condition_variable>  // NOLINT
 #include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <vector>
 
 #include "common/config.h"
+#include "common/macros.h"
+#include "storage/disk/async_io_backend.h"
+#include "storage/disk/free_page_map.h"
 
 namespace bustub {
 
+/** When DiskManager makes writes durable with fdatasync. */
+enum class DurabilityMode {
+  /** Never; writes reach the OS and survive a crash of the process, not of the machine. */
+  NONE,
+  /** On SyncData and SyncLog, which the buffer pool calls once per flush of all pages, and on ShutDown. */
+  SYNC_ON_CHECKPOINT,
+  /** After every page and log write, before it counts as done. Concurrent writers share syncs. */
+  SYNC_EACH_WRITE
+};
+
+/** Id of a segment: one file of the database, e.g. holding the pages of one table or index. */
+using segment_id_t = int32_t;
+
+/** Writes to a file that is synced in batches, see DiskManager::SyncData. Internal to DiskManager. */
+struct SyncState {
+  /** Descriptor to sync, for the log; the data and the segment files are synced through their own descriptors. */
+  int fd_{-1};
+  /** Number of writes done. */
+  std::atomic<uint64_t> write_seq_{0};
+  /** Number of writes that the last sync covered. Protected by latch_. */
+  uint64_t synced_seq_{0};
+  /** Whether a thread is in fdatasync. Protected by latch_. */
+  bool syncing_{false};
+  std::mutex latch_;
+  std::condition_variable cv_;
+};
+
+/**
+ * An open segment file. Whoever does I/O on it holds a reference, so that dropping the segment closes the file only
+ * once that I/O is done, and the descriptor is not reused for another file in the meantime. Internal to DiskManager.
+ */
+struct SegmentFile {
+  ~SegmentFile();
+
+  /** Descriptor of the file; all page I/O is positional, so threads do not share a file cursor and need no latch. */
+  int fd_{-1};
+  /** Size of the file, kept up to date by the writes so that reads need not stat the file. */
+  std::atomic<size_t> file_size_{0};
+  /** Page number in the segment where the next extent starts. Protected by the extent latch of the disk manager. */
+  size_t next_page_no_{0};
+  /** Writes to this file alone, which SYNC_EACH_WRITE syncs. */
+  SyncState sync_;
+};
+
+/** How DiskManager accesses the database file. */
+enum class DiskIoMode {
+  /** Positional reads and writes through the OS page cache. */
+  BUFFERED,
+  /**
+   * Direct I/O (O_DIRECT) that bypasses the OS page cache, so that pages are cached once, in the buffer pool, instead
+   * of twice. Buffers must be aligned to DIRECT_IO_ALIGNMENT, like the frames of a buffer pool are; other buffers go
+   * through an aligned copy. Falls back to BUFFERED if the file system does not support direct I/O.
+   */
+  DIRECT,
+  /**
+   * The file is opened read-only and mapped into memory, e.g. for a replica rebuilt from a backup. Reads are copies out
+   * of the mapping, and the buffer pool can serve pages from the mapping itself, see GetMappedPage. Such pages must be
+   * write-latched to be modified. Writes to the file are dropped.
+   */
+  MMAP_READ_ONLY
+};
+
+/** Alignment of the buffers of direct I/O. Page offsets in the file are multiples of it too. */
+static constexpr size_t DIRECT_IO_ALIGNMENT = PAGE_SIZE;
+
+/** A buffer of whole pages aligned for direct I/O, for copies of pages on their way to or from the disk. */
+class AlignedPageBuffer {
+ public:
+  /** @param num_pages number of pages the buffer holds */
+  explicit AlignedPageBuffer(size_t num_pages);
+
+  ~AlignedPageBuffer();
+
+  DISALLOW_COPY_AND_MOVE(AlignedPageBuffer);
+
+  /** @return the data of a page of the buffer */
+  char *GetPage(size_t index) { return data_ + index * PAGE_SIZE; }
+
+ private:
+  char *data_;
+};
+
+/** How the database file is going to be read, for the read-ahead of the kernel. */
+enum class AccessPattern {
+  /** The default read-ahead. */
+  NORMAL,
+  /** In page id order, e.g. by table scans: read ahead aggressively and drop pages soon after they are read. */
+  SEQUENTIAL,
+  /** At random, e.g. by index lookups: read only the pages asked for. */
+  RANDOM
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * The database is a set of segments, one file each. The upper bits of a page id are the id of its segment, the lower
+ * SEGMENT_PAGE_BITS its page number within the file. The main segment is the db file itself and holds the pages the
+ * buffer pool allocates; the others are created for tables and indexes that want a file of their own, which can then
+ * be read ahead, truncated and dropped on its own. Segment files are named after the db file: test.db.1, test.db.2...
+ * Which of them belong to the database is recorded in the segment list, test.seg next to test.db; files of that name
+ * that are not on the list are left alone.
+ *
+ * The page reads and writes are virtual, so that a stand-in for a slower device can wrap them, see
+ * SimulatedDiskManager.
  */
 class DiskManager {
  public:
+  /** Number of low bits of a page id that are the page number within its segment. */
+  static constexpr int SEGMENT_PAGE_BITS = 24;
+  /** Number of pages a segment can hold. */
+  static constexpr size_t SEGMENT_MAX_PAGES = size_t{1} << SEGMENT_PAGE_BITS;
+  /** Number of segments, including the main one. Page ids are non-negative, so 31 bits are left for both parts. */
+  static constexpr segment_id_t MAX_SEGMENTS = 1 << (31 - SEGMENT_PAGE_BITS);
+  /** The segment that is the db file. */
+  static constexpr segment_id_t MAIN_SEGMENT = 0;
+
+  /** @return the segment a page belongs to */
+  static segment_id_t GetSegmentId(page_id_t page_id) { return page_id >> SEGMENT_PAGE_BITS; }
+
+  /** @return the id of the first page of a segment */
+  static page_id_t GetFirstPageId(segment_id_t segment_id) { return segment_id << SEGMENT_PAGE_BITS; }
+
+  /** @return the offset of a page in the file of its segment */
+  static off_t GetPageOffset(page_id_t page_id) {
+    return static_cast<off_t>(page_id & (SEGMENT_MAX_PAGES - 1)) * PAGE_SIZE;
+  }
+
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param async_io_type how to run the asynchronous reads and writes
+   * @param durability_mode when to make writes durable
+   * @param io_mode how to access the database file; MMAP_READ_ONLY needs an existing file
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, AsyncIoType async_io_type = AsyncIoType::AUTO,
+                       DurabilityMode durability_mode = DurabilityMode::NONE,
+                       DiskIoMode io_mode = DiskIoMode::BUFFERED);
 
-  ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -42,18 +179,150 @@ class DiskManager {
   void ShutDown();
 
   /**
-   * Write a page to the database file.
+   * Write a page to the database file. Throws if the page belongs to a segment that was dropped.
    * @param page_id id of the page
    * @param page_data raw page data
    */
-  void WritePage(page_id_t page_id, const char *page_data);
+  virtual void WritePage(page_id_t page_id, const char *page_data);
+
+  /**
+   * Write a run of consecutive pages to the database file, with as few system calls as possible.
+   * @param first_page_id id of the first page of the run
+   * @param page_data raw data of each page of the run, in page id order
+   * @param num_pages number of pages in the run
+   */
+  virtual void WritePages(page_id_t first_page_id, const char *const *page_data, size_t num_pages);
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
-  void ReadPage(page_id_t page_id, char *page_data);
+  virtual void ReadPage(page_id_t page_id, char *page_data);
+
+  /**
+   * Read a run of consecutive pages from the database file, with as few system calls as possible. Pages past the end
+   * of the file read as zeroes.
+   * @param first_page_id id of the first page of the run
+   * @param[out] page_data output buffer of each page of the run, in page id order
+   * @param num_pages number of pages in the run
+   */
+  virtual void ReadPages(page_id_t first_page_id, char *const *page_data, size_t num_pages);
+
+  /**
+   * Start writing a run of consecutive pages. The page data must stay unchanged until the write is done.
+   * @param first_page_id id of the first page of the run
+   * @param page_data raw data of each page of the run, in page id order
+   * @param num_pages number of pages in the run
+   * @return a future that is ready once the pages are written; under SYNC_EACH_WRITE, waiting for it syncs them
+   */
+  virtual std::future<void> WritePagesAsync(page_id_t first_page_id, const char *const *page_data, size_t num_pages);
+
+  /**
+   * Start reading a run of consecutive pages. Pages past the end of the file read as zeroes.
+   * @param first_page_id id of the first page of the run
+   * @param[out] page_data output buffer of each page of the run, in page id order
+   * @param num_pages number of pages in the run
+   * @return a future that is ready once the pages are read
+   */
+  virtual std::future<void> ReadPagesAsync(page_id_t first_page_id, char *const *page_data, size_t num_pages);
+
+  /**
+   * Get a page of the mapped database file, for the buffer pool to use in place of a copy in a frame. The mapping is
+   * read-only: a frame that points into it has to be copied before it is modified, see Page::WLatch. It stays valid
+   * until the disk manager is destroyed.
+   * @param page_id id of the page
+   * @return the data of the page, or nullptr if the io mode is not MMAP_READ_ONLY or the page is not in the file
+   */
+  virtual const char *GetMappedPage(page_id_t page_id) const;
+
+  /**
+   * Tell the kernel how a segment is going to be read, so that it reads ahead accordingly.
+   * @param pattern the access pattern
+   * @param segment_id the segment
+   */
+  void AdviseAccess(AccessPattern pattern, segment_id_t segment_id = MAIN_SEGMENT);
+
+  /**
+   * Tell the kernel that a run of pages is going to be read soon, so that it starts reading them in.
+   * @param first_page_id id of the first page of the run
+   * @param num_pages number of pages in the run
+   */
+  void AdviseWillNeed(page_id_t first_page_id, size_t num_pages);
+
+  /**
+   * Make all page writes that are done when this is called durable, unless the durability mode is NONE. Concurrent
+   * callers are batched: a caller that finds a sync going on waits for it, and the waiters then share the next one.
+   * The free page map is written back too.
+   */
+  void SyncData();
+
+  /**
+   * Record that a page is deleted, so that its id can be handed out again. Only pages of the main segment are reused;
+   * the space of other segments comes back when they are truncated or dropped.
+   * @param page_id id of the page
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /**
+   * Take a deleted page for reuse, see FreePageMap::Allocate.
+   * @param limit only ids below it are considered; the buffer pool passes the next id it would allocate, so that the
+   * ids it hands out never come from both sources
+   * @param stride the number of buffer pool instances
+   * @param offset the index of the buffer pool instance
+   * @return the page id, or INVALID_PAGE_ID if no deleted page fits
+   */
+  page_id_t AllocateFreePage(page_id_t limit, uint32_t stride, uint32_t offset);
+
+  /**
+   * Record that a page is in use, in case it was deleted in an earlier run. Throws if the id is past the main segment.
+   * @param page_id id of the page, in the main segment
+   * @return false if the id lies in an extent, in which case the caller must not use it and should try the next one
+   */
+  bool ReservePage(page_id_t page_id);
+
+  /**
+   * Reserve an extent: a run of consecutive page ids above every id handed out so far in a segment, for one table heap
+   * or index. The run starts at a multiple of its length, so extents of the same size line up. In the main segment,
+   * ReservePage refuses the ids in it from then on. Throws if the segment has no room for the extent.
+   * @param num_pages number of pages in the extent
+   * @param segment_id the segment to reserve the extent in
+   * @return the first page id of the extent
+   */
+  page_id_t AllocateExtent(size_t num_pages, segment_id_t segment_id = MAIN_SEGMENT);
+
+  /**
+   * Create a segment with an empty file of its own, and add it to the segment list. Segment ids are not reused.
+   * @return the id of the segment
+   */
+  segment_id_t CreateSegment();
+
+  /**
+   * Drop a segment: take it off the segment list and unlink its file, which gives its space back to the file system.
+   * The buffer pool must not hold pages of it any more, see BufferPoolManager::DiscardSegment; writes to it throw from
+   * now on.
+   * @param segment_id the segment, not the main one
+   */
+  void DropSegment(segment_id_t segment_id);
+
+  /**
+   * Truncate a segment to nothing, so that its page numbers start over. The buffer pool must not hold pages of it any
+   * more, see BufferPoolManager::DiscardSegment.
+   * @param segment_id the segment, not the main one
+   */
+  void TruncateSegment(segment_id_t segment_id);
+
+  /**
+   * @param segment_id the segment
+   * @return the size of the file of a segment in bytes, 0 if there is no such segment
+   */
+  size_t GetSegmentFileSize(segment_id_t segment_id);
+
+  /** @return the number of deleted pages that can be reused */
+  size_t GetNumFreePages() const;
+
+  /** Like SyncData, for the log writes. */
+  void SyncLog();
 
   /**
    * Flush the entire log buffer into disk.
@@ -77,9 +346,24 @@ class DiskManager {
   /** @return true iff the in-memory content has not been flushed yet */
   bool GetFlushState() const;
 
-  /** @return the number of disk writes */
+  /** @return the number of disk writes, counting each page of a WritePages run */
   int GetNumWrites() const;
 
+  /** @return the size of the database file, i.e. of the main segment, in bytes */
+  size_t GetDbFileSize() const;
+
+  /** @return the number of syncs of the segment and log files, one for each file synced */
+  int GetNumSyncs() const;
+
+  /** @return how the database file is accessed; BUFFERED if DIRECT was asked for but is not supported */
+  DiskIoMode GetIoMode() const { return io_mode_; }
+
+  /** @return when writes are made durable */
+  DurabilityMode GetDurabilityMode() const { return durability_mode_; }
+
+  /** @return the backend that runs the asynchronous reads and writes, starting it if need be */
+  AsyncIoType GetAsyncIoType();
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -90,19 +374,97 @@ class DiskManager {
   inline bool HasFlushLogFuture() { return flush_log_f_ != nullptr; }
 
  private:
+  friend class AsyncIoBackend;
+
   int GetFileSize(const std::string &file_name);
+  /** WritePages, without counting the writes. */
+  void WritePagesAt(page_id_t first_page_id, const char *const *page_data, size_t num_pages);
+  /** ReadPages, without going through a subclass, for the reads the disk manager and its backends do on their own. */
+  void ReadPagesAt(page_id_t first_page_id, char *const *page_data, size_t num_pages);
+  /** @return the async I/O backend, created on first use so that disk managers that do no async I/O start no threads */
+  AsyncIoBackend *GetAsyncIo();
+  /** @return the open file of a segment, nullptr if there is none */
+  std::shared_ptr<SegmentFile> GetSegmentFile(segment_id_t segment_id);
+  /** @return the name of the file of a segment */
+  std::string GetSegmentFileName(segment_id_t segment_id) const;
+  /**
+   * Open the file of a segment, with the flags of the io mode.
+   * @param file_name the name of the file
+   * @param create_flags O_CREAT and friends, or 0 to open an existing file
+   * @return the file, nullptr if it cannot be opened
+   */
+  std::shared_ptr<SegmentFile> OpenSegmentFile(const std::string &file_name, int create_flags);
+  /**
+   * Read the segment list, and set next_segment_id_ from it.
+   * @return the ids of the segments on it, none if there is no list
+   */
+  std::vector<segment_id_t> ReadSegmentList();
+  /**
+   * Replace the segment list with the open segments and next_segment_id_. Caller holds segment_latch_.
+   * @return false on failure, in which case the old list is still there
+   */
+  bool WriteSegmentListLocked();
+  /** @return how many pages of a run starting at first_page_id are in the segment of first_page_id */
+  static size_t GetPagesInSegment(page_id_t first_page_id, size_t num_pages) {
+    return std::min(num_pages, SEGMENT_MAX_PAGES - (first_page_id & (SEGMENT_MAX_PAGES - 1)));
+  }
+  /** Raise the file size of a segment to size, if a write went past the end of the file. */
+  static void GrowFileSize(SegmentFile *file, size_t size);
+  /**
+   * Account for a page write to file that is done and ends at end_offset, and sync file under SYNC_EACH_WRITE.
+   * @param sync false to leave the sync to the caller, who must then call Sync on the sync_ of file
+   */
+  void WroteData(SegmentFile *file, size_t end_offset, bool sync = true);
+  /** fdatasync the files of all segments, for a checkpoint. @return false on failure */
+  bool SyncSegmentFiles();
+  /**
+   * Sync a file, unless a sync after all writes done so far has already happened.
+   * @param state the writes to make durable: data_sync_, log_sync_ or the sync_ of a segment file
+   * @param file the segment file state belongs to, nullptr for the others
+   */
+  void Sync(SyncState *state, SegmentFile *file = nullptr);
+  /** Map the db file for MMAP_READ_ONLY. */
+  void MapFile();
+  /** Copy a run of pages out of the mapping, zero-filling past its end. */
+  void ReadMappedPages(page_id_t first_page_id, char *const *page_data, size_t num_pages);
+  /** @return a future that is ready, for async requests that were done right away */
+  static std::future<void> ReadyFuture();
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
   std::string file_name_;
+  /** The segment list: next_segment_id_, then the id of each segment other than the main one, as segment_id_t. */
+  std::string segment_list_name_;
   int num_flushes_;
-  int num_writes_;
+  std::atomic<int> num_writes_;
+  std::atomic<int> num_syncs_{0};
   bool flush_log_;
   std::future<void> *flush_log_f_;
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
+  AsyncIoType async_io_type_;
+  AsyncIoBackend *async_io_{nullptr};
+  /** Deleted pages, stored in a file next to the db file. */
+  FreePageMap *free_page_map_{nullptr};
+  /** Highest page id handed out by ReservePage or AllocateExtent. Protected by extent_latch_. */
+  page_id_t max_page_id_{INVALID_PAGE_ID};
+  /** First and last page id of each extent. Protected by extent_latch_. */
+  std::map<page_id_t, page_id_t> extents_;
+  std::mutex extent_latch_;
+  /** The open segments, indexed by segment id; the main one is always there. */
+  std::vector<std::shared_ptr<SegmentFile>> segments_;
+  /** The id CreateSegment hands out next. */
+  segment_id_t next_segment_id_{MAIN_SEGMENT + 1};
+  /** Protects segments_, next_segment_id_ and the segment list. Taken after extent_latch_. */
+  std::mutex segment_latch_;
+  /** Protects async_io_. */
+  std::mutex async_io_latch_;
+  const DurabilityMode durability_mode_;
+  /** Only changes in the constructor, where DIRECT falls back to BUFFERED if the file system has no direct I/O. */
+  DiskIoMode io_mode_;
+  /** The mapping of the db file in MMAP_READ_ONLY mode, nullptr otherwise or if the file is empty. */
+  char *mapping_{nullptr};
+  size_t mapping_size_{0};
+  SyncState data_sync_;
+  SyncState log_sync_;
 };
 
 }  // namespace bustub
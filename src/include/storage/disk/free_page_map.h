@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map.h
+//
+// Identification: src/include/storage/disk/free_page_map.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>  // NOLINT
+#include <set>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FreePageMap keeps track of the deleted pages of a database file, so that their ids can be handed out again instead
+ * of growing the file. It is a bitmap with one bit per page id, set if the page is free, and is stored next to the
+ * database file as a sequence of bitmap pages of BITS_PER_PAGE bits each.
+ *
+ * The whole map is kept in memory. Freed pages are written back on Flush, which the disk manager calls on checkpoints
+ * and on shutdown, like the buffer pool writes back its dirty pages; a free lost in a crash only leaks the page. A page
+ * taken for reuse is written through instead, before its id is handed out, since a map that still had it as free
+ * after a crash would hand it out a second time. The file is only created once there is something to write.
+ *
+ * Allocate only hands out the ids of one buffer pool instance. For each stride it is asked with, the map counts the
+ * free pages of every instance and remembers where the search of each one may start, so an allocation neither scans
+ * the bitmap when the instance has no free page nor rescans the words it already found empty.
+ */
+class FreePageMap {
+ public:
+  /** Number of page ids a bitmap page covers. */
+  static constexpr size_t BITS_PER_PAGE = PAGE_SIZE * 8;
+
+  /**
+   * Open the map stored in a file, or start an empty one.
+   * @param file_name the file of the map
+   * @param reset whether to ignore what is in the file, e.g. because the database file is new
+   * @param sync whether to fdatasync the file after writing it
+   */
+  FreePageMap(std::string file_name, bool reset, bool sync);
+
+  ~FreePageMap();
+
+  DISALLOW_COPY_AND_MOVE(FreePageMap);
+
+  /**
+   * Mark a page as free.
+   * @param page_id id of the page
+   */
+  void Free(page_id_t page_id);
+
+  /**
+   * Take the lowest free page among the ids that belong to one buffer pool instance, i.e. page_id % stride == offset.
+   * @param limit only ids below it are considered
+   * @param stride the number of buffer pool instances
+   * @param offset the index of the buffer pool instance
+   * @return the page id, or INVALID_PAGE_ID if there is no free page that fits
+   */
+  page_id_t Allocate(page_id_t limit, uint32_t stride, uint32_t offset);
+
+  /**
+   * Mark a page as in use, if the map had it as free.
+   * @param page_id id of the page
+   */
+  void Reserve(page_id_t page_id);
+
+  /** Write back the changed bitmap pages. */
+  void Flush();
+
+  /** @return the number of free pages */
+  size_t GetNumFreePages() const { return num_free_; }
+
+ private:
+  /** The free pages of the buffer pool instances of one stride. */
+  struct Partition {
+    /** Number of free pages per offset. */
+    std::vector<size_t> num_free_;
+    /** Per offset, the first word that may have a free page of it. */
+    std::vector<size_t> first_word_;
+  };
+
+  /** Clear a bit that is set, and write its bitmap page through. Caller must hold latch_. */
+  void ClearLocked(size_t page_id);
+
+  /** @return the partition of a stride, counting its free pages if it is new. Caller must hold latch_. */
+  Partition &GetPartitionLocked(uint32_t stride);
+
+  /** Open the file, creating it. Caller must hold latch_. @return false on failure */
+  bool OpenLocked();
+
+  /** Write one bitmap page to the file, which must be open. Caller must hold latch_. @return false on failure */
+  bool WritePageLocked(size_t page);
+
+  const std::string file_name_;
+  /** Whether writes of the file are synced. */
+  const bool sync_;
+  /** Descriptor of the file, -1 until it is opened. */
+  int fd_{-1};
+  /** The bitmap, 64 page ids per word. */
+  std::vector<uint64_t> words_;
+  /** Bitmap pages that changed since the last Flush. */
+  std::set<size_t> dirty_pages_;
+  /** Partitions of the strides Allocate was called with, by stride. */
+  std::map<uint32_t, Partition> partitions_;
+  /** Number of set bits. Read without latch_ to skip the search when nothing is free. */
+  std::atomic<size_t> num_free_{0};
+  /** Protects everything above. num_free_ changes under it too. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
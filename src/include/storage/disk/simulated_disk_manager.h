@@ -0,0 +1,134 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// simulated_disk_manager.h
+//
+// Identification: src/include/storage/disk/simulated_disk_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <cstdint>
+#include <future>  // NOLINT
+#include <mutex>   // NOLINT
+#include <string>
+#include <vector>
+
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/** The device a SimulatedDiskManager pretends to be. */
+struct SimulatedDiskConfig {
+  /** Time a read takes before its data starts to transfer, e.g. the seek or flash read. */
+  std::chrono::nanoseconds read_latency_{std::chrono::microseconds(100)};
+  /** Time a write takes before its data starts to transfer. */
+  std::chrono::nanoseconds write_latency_{std::chrono::microseconds(20)};
+  /** Bytes per second the device transfers, shared by reads and writes; 0 for no limit. */
+  uint64_t bandwidth_{0};
+  /** Number of requests the device works on at once; the others wait for one of them to finish. */
+  size_t queue_depth_{32};
+};
+
+/**
+ * A snapshot of the counters of a SimulatedDiskManager. A request is one call: a ReadPages call of ten pages is one
+ * read of ten pages.
+ */
+struct DiskIoCounters {
+  /** ReadPage, ReadPages and ReadPagesAsync calls. */
+  uint64_t reads_{0};
+  /** Pages read by them. */
+  uint64_t pages_read_{0};
+  /** ReadPagesAsync calls, included in reads_. */
+  uint64_t async_reads_{0};
+  /** WritePage, WritePages and WritePagesAsync calls. */
+  uint64_t writes_{0};
+  /** Pages written by them. */
+  uint64_t pages_written_{0};
+  /** WritePagesAsync calls, included in writes_. */
+  uint64_t async_writes_{0};
+  /** Total time requests waited for the device to take them because the queue was full, in nanoseconds. */
+  uint64_t queued_ns_{0};
+  /** Total time the device worked on requests, in nanoseconds, from taking a request until it is done. */
+  uint64_t service_ns_{0};
+};
+
+/**
+ * SimulatedDiskManager is a DiskManager that behaves like a slower device than the one the db file is on, for tests
+ * and benchmarks of I/O-bound behavior: a local SSD and the OS page cache answer most requests in microseconds, which
+ * hides the difference between e.g. reading pages one by one and in runs, or with and without prefetching.
+ *
+ * The pages still go to and from the db file. Each request is scheduled on a model of the device: it waits for one of
+ * queue_depth_ slots, then for its latency, then transfers its pages at the bandwidth, which all requests share. A
+ * synchronous call returns, and the future of an asynchronous one becomes ready, when the model says the request is
+ * done. The schedule depends only on the requests and the times they are made, not on the disk below.
+ *
+ * Pages of a read-only mapping are not handed out; mapped pages are read, and waited for, like any others.
+ */
+class SimulatedDiskManager : public DiskManager {
+ public:
+  /**
+   * Creates a disk manager for a simulated device.
+   * @param db_file the file name of the database file to write to
+   * @param config the device to simulate
+   * @param async_io_type how to run the asynchronous reads and writes
+   * @param durability_mode when to make writes durable
+   * @param io_mode how to access the database file
+   */
+  SimulatedDiskManager(const std::string &db_file, const SimulatedDiskConfig &config,
+                       AsyncIoType async_io_type = AsyncIoType::AUTO,
+                       DurabilityMode durability_mode = DurabilityMode::NONE,
+                       DiskIoMode io_mode = DiskIoMode::BUFFERED);
+
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  void WritePages(page_id_t first_page_id, const char *const *page_data, size_t num_pages) override;
+
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  void ReadPages(page_id_t first_page_id, char *const *page_data, size_t num_pages) override;
+
+  std::future<void> WritePagesAsync(page_id_t first_page_id, const char *const *page_data, size_t num_pages) override;
+
+  std::future<void> ReadPagesAsync(page_id_t first_page_id, char *const *page_data, size_t num_pages) override;
+
+  /** @return nullptr, so that the buffer pool reads mapped pages through ReadPage */
+  const char *GetMappedPage(page_id_t page_id) const override { return nullptr; }
+
+  /** @return the device being simulated */
+  const SimulatedDiskConfig &GetConfig() const { return config_; }
+
+  /** @return a snapshot of the counters */
+  DiskIoCounters GetIoCounters();
+
+  /** Set the counters back to zero, e.g. after loading the data of a benchmark. */
+  void ResetIoCounters();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Schedule a request on the device and count it.
+   * @param write whether the request is a write
+   * @param num_pages number of pages of the request
+   * @param async whether the request is asynchronous
+   * @return the time the request is done
+   */
+  Clock::time_point Schedule(bool write, size_t num_pages, bool async);
+
+  const SimulatedDiskConfig config_;
+  /** Time each slot of the device queue becomes free. */
+  std::vector<Clock::time_point> slots_;
+  /** Time the device is done transferring the data of the requests scheduled so far. */
+  Clock::time_point transfer_free_;
+  DiskIoCounters counters_;
+  /** Protects slots_, transfer_free_ and counters_. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
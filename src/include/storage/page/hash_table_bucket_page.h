@@ -46,7 +46,7 @@ class HashTableBucketPage {
    *
    * @return true if at least one key matched
    */
-  bool GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result);
+  bool GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) const;
   bool ExsitKv(KeyType key, KeyComparator cmp, ValueType value);
   /**
    * Attempts to insert a key and value in the bucket.  Uses the occupied_
@@ -121,17 +121,17 @@ class HashTableBucketPage {
   /**
    * @return the number of readable elements, i.e. current size
    */
-  uint32_t NumReadable();
+  uint32_t NumReadable() const;
 
   /**
    * @return whether the bucket is full
    */
-  bool IsFull();
+  bool IsFull() const;
 
   /**
    * @return whether the bucket is empty
    */
-  bool IsEmpty();
+  bool IsEmpty() const;
 
   /**
    * Prints the bucket's occupancy information
@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
+#include <mutex>  // NOLINT
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -30,14 +32,30 @@ class Page {
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
-
-  /** Default destructor. */
-  ~Page() = default;
-
-  /** @return the actual data contained within this page */
-  inline char *GetData() { return data_; }
+  /** Constructor. Allocates the page data and zeros it out. */
+  Page() : data_(new char[PAGE_SIZE]), frame_data_(data_), owns_data_(true) { ResetMemory(); }
+
+  /** Destructor. Frees the page data unless it belongs to a buffer pool. */
+  ~Page() {
+    if (owns_data_) {
+      delete[] frame_data_;
+    }
+  }
+
+  /**
+   * A page that the buffer pool serves from a read-only mapping of the database file is copied into its frame first,
+   * so that writing through the result never touches the mapping, whatever latch the caller holds.
+   * @return the actual data contained within this page, which the caller may modify
+   */
+  inline char *GetData() {
+    if (data_ != frame_data_) {
+      CopyIntoFrame();
+    }
+    return data_;
+  }
+
+  /** @return the data of this page, for reading; for a page served from a read-only mapping, the mapping itself */
+  inline const char *GetData() const { return data_; }
 
   /** @return the page id of this page */
   inline page_id_t GetPageId() { return page_id_; }
@@ -48,8 +66,17 @@ class Page {
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline bool IsDirty() { return is_dirty_; }
 
-  /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  /**
+   * Acquire the page write latch. A page that the buffer pool serves from a read-only mapping of the database file is
+   * copied into its frame first, so that it can be modified; the data moves, so pointers into it taken before the
+   * latch are stale.
+   */
+  inline void WLatch() {
+    rwlatch_.WLock();
+    if (data_ != frame_data_) {
+      CopyIntoFrame();
+    }
+  }
 
   /** Release the page write latch. */
   inline void WUnlatch() { rwlatch_.WUnlock(); }
@@ -61,7 +88,7 @@ class Page {
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
   /** @return the page LSN. */
-  inline lsn_t GetLSN() { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
+  inline lsn_t GetLSN() const { return *reinterpret_cast<const lsn_t *>(GetData() + OFFSET_LSN); }
 
   /** Sets the page LSN. */
   inline void SetLSN(lsn_t lsn) { memcpy(GetData() + OFFSET_LSN, &lsn, sizeof(lsn_t)); }
@@ -75,19 +102,46 @@ class Page {
   static constexpr size_t OFFSET_LSN = 4;
 
  private:
+  /** Constructor for the frames of a buffer pool, whose data lives in the pool's frame arena. */
+  explicit Page(char *data) : data_(data), frame_data_(data), owns_data_(false) {}
+
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[PAGE_SIZE]{};
+  /** Copy a page served from a read-only mapping into the frame, once, and point data_ at the copy. */
+  void CopyIntoFrame() {
+    std::lock_guard<std::mutex> guard(copy_latch_);
+    char *data = data_;
+    if (data != frame_data_) {
+      memcpy(frame_data_, data, PAGE_SIZE);
+      data_ = frame_data_;
+    }
+  }
+
+  /**
+   * The actual data that is stored within a page, PAGE_SIZE bytes. Either frame_data_, or the page in a read-only
+   * mapping of the database file until it is written or write-latched. Only changes under copy_latch_, or while the
+   * buffer pool loads the frame. Atomic so that GetData can check it without taking a latch.
+   */
+  std::atomic<char *> data_;
+  /** The memory of the frame. */
+  char *frame_data_;
+  /** True if frame_data_ was allocated by this page. */
+  bool owns_data_;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
-  /** The pin count of this page. */
-  int pin_count_ = 0;
+  /** The pin count of this page. Atomic so that it can be read without holding the frame latch. */
+  std::atomic<int> pin_count_{0};
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
   bool is_dirty_ = false;
+  /** True from NewPage until the page is first written. The disk has no copy of it yet, so FlushPage writes it. */
+  bool is_new_ = false;
+  /** True while the buffer pool is still reading this page in. Other users of the page must wait for it to clear. */
+  std::atomic<bool> io_in_progress_{false};
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Serializes the copy of a mapped page into the frame, which writers may start without the page latch. */
+  std::mutex copy_latch_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,245 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class ReadPageGuard;
+class WritePageGuard;
+
+/**
+ * BasicPageGuard holds a pin on a page and unpins it when it goes out of scope, through the frame pointer rather than
+ * another page table lookup. Guards can be moved but not copied, so every pin is released exactly once.
+ *
+ * A guard may be empty, e.g. if the page could not be fetched because every frame was pinned; check with IsValid.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  /**
+   * Take over a pin on a page.
+   * @param bpm the buffer pool manager the page was fetched from
+   * @param page the pinned page, or nullptr for an empty guard
+   */
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  BasicPageGuard &operator=(const BasicPageGuard &) = delete;
+
+  /** Take over the pin of another guard, leaving that one empty. */
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** Release the pin this guard holds, if any, and take over the pin of another guard. */
+  BasicPageGuard &operator=(BasicPageGuard &&that) noexcept;
+
+  /** Release the pin. */
+  ~BasicPageGuard() { Drop(); }
+
+  /** Unpin the page now, marking it dirty if it was modified through the guard. The guard is empty afterwards. */
+  void Drop();
+
+  /**
+   * Take the page's read latch and turn this guard into a ReadPageGuard. This guard is empty afterwards.
+   * @return a guard holding both the pin and the read latch
+   */
+  ReadPageGuard UpgradeRead();
+
+  /**
+   * Take the page's write latch and turn this guard into a WritePageGuard. This guard is empty afterwards.
+   * @return a guard holding both the pin and the write latch
+   */
+  WritePageGuard UpgradeWrite();
+
+  /** @return true if the guard holds a page */
+  bool IsValid() const { return page_ != nullptr; }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return page_->GetPageId(); }
+
+  /** @return the data of the guarded page, for reading; a page served from a read-only mapping is not copied */
+  const char *GetData() { return std::as_const(*page_).GetData(); }
+
+  /** @return the data of the guarded page reinterpreted as T, for reading */
+  template <class T>
+  const T *As() {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+  /**
+   * A page served from a read-only mapping is copied into its frame first, see Page::GetData.
+   * @return the data of the guarded page, for writing. Marks the page dirty.
+   */
+  char *GetDataMut() {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  /** @return the data of the guarded page reinterpreted as T, for writing. Marks the page dirty. */
+  template <class T>
+  T *AsMut() {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+  /**
+   * For page types that derive from Page, such as TablePage. Does not mark the page dirty; call SetDirty after
+   * modifying it.
+   * @return the guarded page as T
+   */
+  template <class T>
+  T *AsPage() {
+    return static_cast<T *>(page_);
+  }
+
+  /** Mark the page dirty, so that it is written back after it is unpinned. */
+  void SetDirty() { is_dirty_ = true; }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+
+  BufferPoolManager *bpm_ = nullptr;
+  Page *page_ = nullptr;
+  bool is_dirty_ = false;
+};
+
+/**
+ * ReadPageGuard holds a pin and the read latch on a page, and releases both when it goes out of scope.
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /**
+   * Take over a pin and the read latch on a page.
+   * @param bpm the buffer pool manager the page was fetched from
+   * @param page the pinned and read-latched page, or nullptr for an empty guard
+   */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  ReadPageGuard &operator=(const ReadPageGuard &) = delete;
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** Release the latch and pin this guard holds, if any, and take over those of another guard. */
+  ReadPageGuard &operator=(ReadPageGuard &&that) noexcept;
+
+  /** Release the latch and the pin. */
+  ~ReadPageGuard() { Drop(); }
+
+  /** Release the read latch, then unpin the page. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  bool IsValid() const { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return guard_.PageId(); }
+
+  /** @return the data of the guarded page */
+  const char *GetData() { return guard_.GetData(); }
+
+  /** @return the data of the guarded page reinterpreted as T */
+  template <class T>
+  const T *As() {
+    return guard_.As<T>();
+  }
+
+  /** @return the guarded page as T, for page types that derive from Page. It must only be read. */
+  template <class T>
+  T *AsPage() {
+    return guard_.AsPage<T>();
+  }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard holds a pin and the write latch on a page, and releases both when it goes out of scope.
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /**
+   * Take over a pin and the write latch on a page.
+   * @param bpm the buffer pool manager the page was fetched from
+   * @param page the pinned and write-latched page, or nullptr for an empty guard
+   */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  WritePageGuard &operator=(const WritePageGuard &) = delete;
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** Release the latch and pin this guard holds, if any, and take over those of another guard. */
+  WritePageGuard &operator=(WritePageGuard &&that) noexcept;
+
+  /** Release the latch and the pin. */
+  ~WritePageGuard() { Drop(); }
+
+  /** Release the write latch, then unpin the page. The guard is empty afterwards. */
+  void Drop();
+
+  /** @return true if the guard holds a page */
+  bool IsValid() const { return guard_.IsValid(); }
+
+  /** @return the id of the guarded page */
+  page_id_t PageId() { return guard_.PageId(); }
+
+  /** @return the data of the guarded page, for reading */
+  const char *GetData() { return guard_.GetData(); }
+
+  /** @return the data of the guarded page reinterpreted as T, for reading */
+  template <class T>
+  const T *As() {
+    return guard_.As<T>();
+  }
+
+  /** @return the data of the guarded page, for writing. Marks the page dirty. */
+  char *GetDataMut() { return guard_.GetDataMut(); }
+
+  /** @return the data of the guarded page reinterpreted as T, for writing. Marks the page dirty. */
+  template <class T>
+  T *AsMut() {
+    return guard_.AsMut<T>();
+  }
+
+  /**
+   * For page types that derive from Page, such as TablePage. Does not mark the page dirty; call SetDirty after
+   * modifying it.
+   * @return the guarded page as T
+   */
+  template <class T>
+  T *AsPage() {
+    return guard_.AsPage<T>();
+  }
+
+  /** Mark the page dirty, so that it is written back after it is unpinned. */
+  void SetDirty() { guard_.SetDirty(); }
+
+ private:
+  friend class BasicPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+}  // namespace bustub
@@ -31,7 +31,7 @@ class TableHeap {
   ~TableHeap() = default;
 
   /**
-   * Create a table heap without a transaction. (open table)
+   * Create a table heap without a transaction. (open table) New pages go to the segment of the first page.
    * @param buffer_pool_manager the buffer pool manager
    * @param lock_manager the lock manager
    * @param log_manager the log manager
@@ -46,9 +46,10 @@ class TableHeap {
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param txn the creating transaction
+   * @param segment_id the segment to put the pages of the table in, see DiskManager::CreateSegment
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            Transaction *txn);
+            Transaction *txn, segment_id_t segment_id = DiskManager::MAIN_SEGMENT);
 
   /**
    * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
@@ -95,12 +96,18 @@ class TableHeap {
    * @param rid rid of the tuple to read
    * @param tuple output variable for the tuple
    * @param txn transaction performing the read
+   * @param strategy the ring of a bulk read to fetch the page through, or nullptr
    * @return true if the read was successful (i.e. the tuple exists)
    */
-  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
+  bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
-  /** @return the begin iterator of this table */
-  TableIterator Begin(Transaction *txn);
+  /**
+   * @param txn transaction performing the scan
+   * @param strategy the ring to confine the scan to, or nullptr to fetch pages like any other; must outlive the
+   * iterators of the scan
+   * @return the begin iterator of this table
+   */
+  TableIterator Begin(Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
   /** @return the end iterator of this table */
   TableIterator End();
@@ -108,11 +115,23 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline page_id_t GetFirstPageId() const { return first_page_id_; }
 
+  /**
+   * Set how many pages ahead of the current one iterators of this table prefetch.
+   * @param read_ahead_pages the read-ahead window in pages, 0 disables read-ahead
+   */
+  inline void SetReadAheadPages(size_t read_ahead_pages) { read_ahead_pages_ = read_ahead_pages; }
+
+  /** Default read-ahead window of a table scan, in pages. */
+  static constexpr size_t DEFAULT_READ_AHEAD_PAGES = 8;
+
  private:
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  size_t read_ahead_pages_{DEFAULT_READ_AHEAD_PAGES};
+  /** Hands out the ids of new pages, so that the pages of the heap follow each other on disk and scans read runs. */
+  ExtentAllocator extent_;
 };
 
 }  // namespace bustub
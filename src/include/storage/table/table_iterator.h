@@ -14,6 +14,7 @@
 
 #include <cassert>
 
+#include "buffer/buffer_access_strategy.h"
 #include "common/rid.h"
 #include "concurrency/transaction.h"
 #include "storage/table/tuple.h"
@@ -29,10 +30,14 @@ class TableIterator {  // 每个Heap对应了多个Iterator，一个表对应一
   friend class Cursor;
 
  public:
-  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn);
+  TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy = nullptr);
 
   TableIterator(const TableIterator &other)
-      : table_heap_(other.table_heap_), tuple_(new Tuple(*other.tuple_)), txn_(other.txn_) {}
+      : table_heap_(other.table_heap_),
+        tuple_(new Tuple(*other.tuple_)),
+        txn_(other.txn_),
+        strategy_(other.strategy_),
+        readahead_page_id_(other.readahead_page_id_) {}
 
   ~TableIterator() { delete tuple_; }
 
@@ -52,13 +57,29 @@ class TableIterator {  // 每个Heap对应了多个Iterator，一个表对应一
     table_heap_ = other.table_heap_;
     *tuple_ = *other.tuple_;
     txn_ = other.txn_;
+    strategy_ = other.strategy_;
+    readahead_page_id_ = other.readahead_page_id_;
     return *this;
   }
 
  private:
+  /**
+   * Called whenever the iterator moves onto a page of the heap. Keeps up to read_ahead_pages_ of the following pages
+   * prefetched. A heap fills the extents it reserves in order, so inside an extent the following pages have the
+   * following ids, and the window is prefetched by id without reading the pages of the chain in between. Where the
+   * chain leaves the extent, the window restarts at the next page, which only the last page of the extent knows.
+   * @param page_id the page the iterator just moved onto
+   * @param next_page_id the page after it in the chain, INVALID_PAGE_ID if there is none or it is not known
+   */
+  void ReadAhead(page_id_t page_id, page_id_t next_page_id);
+
   TableHeap *table_heap_;
   Tuple *tuple_;
   Transaction *txn_;
+  /** The ring the scan is confined to, nullptr if it fetches pages like any other. Not owned. */
+  BufferAccessStrategy *strategy_{nullptr};
+  /** The last page that was prefetched. */
+  page_id_t readahead_page_id_{INVALID_PAGE_ID};
 };
 
 }  // namespace bustub
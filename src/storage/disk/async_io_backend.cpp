@@ -0,0 +1,302 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_io_backend.cpp
+//
+// Identification: src/storage/disk/async_io_backend.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_io_backend.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include "common/logger.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+namespace {
+
+int IoUringSetup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int IoUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+}  // namespace
+
+AsyncIoBackend *AsyncIoBackend::Create(AsyncIoType type, DiskManager *disk_manager) {
+  if (type != AsyncIoType::THREAD_POOL) {
+    AsyncIoBackend *backend = IoUringBackend::Create(disk_manager);
+    if (backend != nullptr) {
+      return backend;
+    }
+    LOG_DEBUG("io_uring is not available, falling back to a thread pool");
+  }
+  return new ThreadPoolIoBackend(disk_manager);
+}
+
+AsyncIoBackend::AsyncIoBackend(DiskManager *disk_manager) : disk_manager_(disk_manager) {}
+
+void AsyncIoBackend::FinishRequest(AsyncIoRequest *request, bool done) {
+  size_t num_pages = request->page_data_.size();
+  if (!done) {
+    if (request->write_) {
+      disk_manager_->WritePagesAt(request->first_page_id_, request->page_data_.data(), num_pages);
+    } else {
+      disk_manager_->ReadPagesAt(request->first_page_id_, request->page_data_.data(), num_pages);
+    }
+  } else if (request->write_) {
+    // Under SYNC_EACH_WRITE, the future of the write syncs when it is waited for; see DiskManager::WritePagesAsync.
+    disk_manager_->WroteData(request->file_.get(),
+                             DiskManager::GetPageOffset(request->first_page_id_) + num_pages * PAGE_SIZE, false);
+  }
+  request->promise_.set_value();
+  delete request;
+}
+
+/*
+ * IoUringBackend
+ */
+
+IoUringBackend *IoUringBackend::Create(DiskManager *disk_manager) {
+  auto *backend = new IoUringBackend(disk_manager);
+  if (!backend->Setup()) {
+    delete backend;
+    return nullptr;
+  }
+  backend->reaper_ = new std::thread(&IoUringBackend::RunReaper, backend);
+  return backend;
+}
+
+bool IoUringBackend::Setup() {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring_fd_ = IoUringSetup(QUEUE_DEPTH, &params);
+  if (ring_fd_ < 0) {
+    return false;
+  }
+  sq_entries_ = params.sq_entries;
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                  IORING_OFF_SQ_RING);
+  if (sq_ring_ == MAP_FAILED) {
+    sq_ring_ = nullptr;
+    return false;
+  }
+  if (single_mmap) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                    IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      cq_ring_ = nullptr;
+      return false;
+    }
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  void *sqes = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return false;
+  }
+  sqes_ = static_cast<io_uring_sqe *>(sqes);
+
+  auto *sq = static_cast<char *>(sq_ring_);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  auto *cq = static_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+  return true;
+}
+
+void IoUringBackend::Teardown() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+}
+
+IoUringBackend::~IoUringBackend() {
+  if (reaper_ != nullptr) {
+    // Let the requests in flight complete, then wake up the reaper with a no-op that tells it to stop.
+    std::unique_lock<std::mutex> guard(latch_);
+    cv_.wait(guard, [&] { return in_flight_ == 0; });
+    bool pushed = PushSqe(IORING_OP_NOP, nullptr);
+    BUSTUB_ASSERT(pushed, "could not stop the io_uring reaper");
+    guard.unlock();
+    reaper_->join();
+    delete reaper_;
+  }
+  Teardown();
+}
+
+bool IoUringBackend::PushSqe(uint8_t opcode, AsyncIoRequest *request) {
+  // We are the only producer, so the tail is ours. The kernel reads it, so publish it with release semantics.
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  io_uring_sqe *sqe = sqes_ + index;
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = -1;
+  if (request != nullptr) {
+    sqe->fd = request->file_->fd_;
+    sqe->addr = reinterpret_cast<uint64_t>(request->iovs_.data());
+    sqe->len = request->iovs_.size();
+    sqe->off = DiskManager::GetPageOffset(request->first_page_id_);
+  }
+  sqe->user_data = reinterpret_cast<uint64_t>(request);
+  sq_array_[index] = index;
+  if (request != nullptr) {
+    // The request belongs to the reaper from here on.
+    request->submitted_.store(true, std::memory_order_release);
+  }
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  while (true) {
+    int ret = IoUringEnter(ring_fd_, 1, 0, 0);
+    if (ret == 1) {
+      return true;
+    }
+    if (ret < 0 && (errno == EINTR || errno == EAGAIN)) {
+      continue;
+    }
+    // The kernel did not take the entry, so take it back.
+    LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+    return false;
+  }
+}
+
+void IoUringBackend::Submit(AsyncIoRequest *request) {
+  // A readv or writev takes at most IOV_MAX buffers. Longer runs are rare enough to do synchronously.
+  if (request->page_data_.size() > IOV_MAX) {
+    FinishRequest(request, false);
+    return;
+  }
+  request->iovs_.resize(request->page_data_.size());
+  for (size_t i = 0; i < request->page_data_.size(); i++) {
+    request->iovs_[i].iov_base = request->page_data_[i];
+    request->iovs_[i].iov_len = PAGE_SIZE;
+  }
+  std::unique_lock<std::mutex> guard(latch_);
+  // The completion queue has twice as many entries, so bounding the requests in flight by the submission queue means
+  // completions never overflow.
+  cv_.wait(guard, [&] { return in_flight_ < sq_entries_; });
+  if (!PushSqe(request->write_ ? IORING_OP_WRITEV : IORING_OP_READV, request)) {
+    guard.unlock();
+    FinishRequest(request, false);
+    return;
+  }
+  in_flight_++;
+}
+
+void IoUringBackend::RunReaper() {
+  while (true) {
+    if (IoUringEnter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+      LOG_DEBUG("io_uring_enter failed: %s", strerror(errno));
+    }
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    size_t completed = 0;
+    bool stop = false;
+    for (; head != tail; head++) {
+      io_uring_cqe *cqe = cqes_ + (head & *cq_mask_);
+      auto *request = reinterpret_cast<AsyncIoRequest *>(cqe->user_data);
+      if (request == nullptr) {
+        stop = true;
+        continue;
+      }
+      request->submitted_.load(std::memory_order_acquire);
+      // A short transfer, e.g. a read past the end of the file, or an error is finished synchronously.
+      auto expected = static_cast<int>(request->page_data_.size() * PAGE_SIZE);
+      FinishRequest(request, cqe->res == expected);
+      completed++;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    if (completed > 0) {
+      std::lock_guard<std::mutex> guard(latch_);
+      in_flight_ -= completed;
+      cv_.notify_all();
+    }
+    if (stop) {
+      return;
+    }
+  }
+}
+
+/*
+ * ThreadPoolIoBackend
+ */
+
+ThreadPoolIoBackend::ThreadPoolIoBackend(DiskManager *disk_manager) : AsyncIoBackend(disk_manager) {
+  for (size_t i = 0; i < NUM_THREADS; i++) {
+    workers_.emplace_back(&ThreadPoolIoBackend::RunWorker, this);
+  }
+}
+
+ThreadPoolIoBackend::~ThreadPoolIoBackend() {
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    running_ = false;
+  }
+  cv_.notify_all();
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPoolIoBackend::Submit(AsyncIoRequest *request) {
+  {
+    std::lock_guard<std::mutex> guard(latch_);
+    queue_.push_back(request);
+  }
+  cv_.notify_one();
+}
+
+void ThreadPoolIoBackend::RunWorker() {
+  std::unique_lock<std::mutex> guard(latch_);
+  while (true) {
+    // Requests that are queued when the backend goes away still get done.
+    cv_.wait(guard, [&] { return !running_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      return;
+    }
+    AsyncIoRequest *request = queue_.front();
+    queue_.pop_front();
+    guard.unlock();
+    FinishRequest(request, false);
+    guard.lock();
+  }
+}
+
+}  // namespace bustub
@@ -10,13 +10,21 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
 #include <cstring>
 #include <iostream>
 #include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
+#include <vector>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -26,18 +34,81 @@ namespace bustub {
 
 static char *buffer_used;
 
+namespace {
+
+/** pwrite all of a buffer, resuming after short writes. */
+bool PwriteAll(int fd, const char *data, size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t written = pwrite(fd, data, size, offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data += written;
+    size -= written;
+    offset += written;
+  }
+  return true;
+}
+
+/** Drop the first count bytes of an iovec array, e.g. the part a short vectored read or write got through. */
+void AdvanceIovecs(iovec **iov, int *iovcnt, size_t count) {
+  while (*iovcnt > 0 && count >= (*iov)->iov_len) {
+    count -= (*iov)->iov_len;
+    (*iov)++;
+    (*iovcnt)--;
+  }
+  if (*iovcnt > 0) {
+    (*iov)->iov_base = static_cast<char *>((*iov)->iov_base) + count;
+    (*iov)->iov_len -= count;
+  }
+}
+
+/** @return true if all page buffers of a run can be used for direct I/O as they are */
+bool IsAligned(const char *const *page_data, size_t num_pages) {
+  for (size_t i = 0; i < num_pages; i++) {
+    if (reinterpret_cast<uintptr_t>(page_data[i]) % DIRECT_IO_ALIGNMENT != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+AlignedPageBuffer::AlignedPageBuffer(size_t num_pages)
+    : data_(static_cast<char *>(aligned_alloc(DIRECT_IO_ALIGNMENT, std::max<size_t>(num_pages, 1) * PAGE_SIZE))) {
+  if (data_ == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "can't allocate an aligned page buffer");
+  }
+}
+
+AlignedPageBuffer::~AlignedPageBuffer() { free(data_); }
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file)
-    : file_name_(db_file), num_flushes_(0), num_writes_(0), flush_log_(false), flush_log_f_(nullptr) {
+DiskManager::DiskManager(const std::string &db_file, AsyncIoType async_io_type, DurabilityMode durability_mode,
+                         DiskIoMode io_mode)
+    : file_name_(db_file),
+      num_flushes_(0),
+      num_writes_(0),
+      flush_log_(false),
+      flush_log_f_(nullptr),
+      async_io_type_(async_io_type),
+      segments_(MAX_SEGMENTS),
+      durability_mode_(durability_mode),
+      io_mode_(io_mode) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  segment_list_name_ = file_name_.substr(0, n) + ".seg";
 
   log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -52,31 +123,265 @@ DiskManager::DiskManager(const std::string &db_file)
       throw Exception("can't open dblog file");
     }
   }
+  // the stream cannot be synced, so keep a descriptor of the log file for that
+  log_sync_.fd_ = open(log_name_.c_str(), O_RDONLY);
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out);
-    db_io_.close();
-    // reopen with original mode
-    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
+  // open the db file, creating it if it does not exist, unless it is a read-only replica
+  const bool new_db_file = access(db_file.c_str(), F_OK) != 0;
+  auto main_file = OpenSegmentFile(db_file, io_mode_ == DiskIoMode::MMAP_READ_ONLY ? 0 : O_CREAT);
+  if (main_file == nullptr && io_mode_ == DiskIoMode::DIRECT && errno == EINVAL) {
+    // The mode is settled here, before any I/O, for all files: the segment files live next to the db file.
+    LOG_DEBUG("the file system does not support direct I/O, falling back to buffered I/O");
+    io_mode_ = DiskIoMode::BUFFERED;
+    main_file = OpenSegmentFile(db_file, O_CREAT);
+  }
+  if (main_file == nullptr) {
+    throw Exception("can't open db file");
+  }
+  const size_t db_file_size = main_file->file_size_;
+  segments_[MAIN_SEGMENT] = std::move(main_file);
+  max_page_id_ = static_cast<page_id_t>(db_file_size / PAGE_SIZE) - 1;
+  if (io_mode_ == DiskIoMode::MMAP_READ_ONLY) {
+    MapFile();
+  }
+  // Open the other segments on the list. The segments of an earlier db file of the same name are removed with its
+  // list. The main segment may well be empty when the tables live in segments of their own, so only a db file we
+  // created is new.
+  const std::vector<segment_id_t> segment_ids = ReadSegmentList();
+  if (new_db_file) {
+    for (segment_id_t segment_id : segment_ids) {
+      unlink(GetSegmentFileName(segment_id).c_str());
+    }
+    unlink(segment_list_name_.c_str());
+    next_segment_id_ = MAIN_SEGMENT + 1;
+  }
+  for (segment_id_t segment_id : new_db_file ? std::vector<segment_id_t>() : segment_ids) {
+    segments_[segment_id] = OpenSegmentFile(GetSegmentFileName(segment_id), 0);
+    if (segments_[segment_id] == nullptr) {
+      throw Exception("can't open segment file");
     }
+    segments_[segment_id]->next_page_no_ = segments_[segment_id]->file_size_ / PAGE_SIZE;
   }
+  free_page_map_ = new FreePageMap(file_name_.substr(0, n) + ".fsm", db_file_size == 0,
+                                   durability_mode_ != DurabilityMode::NONE);
   buffer_used = nullptr;
 }
 
+SegmentFile::~SegmentFile() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+std::shared_ptr<SegmentFile> DiskManager::OpenSegmentFile(const std::string &file_name, int create_flags) {
+  auto file = std::make_shared<SegmentFile>();
+  if (io_mode_ == DiskIoMode::MMAP_READ_ONLY) {
+    file->fd_ = open(file_name.c_str(), O_RDONLY);
+  } else if (io_mode_ == DiskIoMode::DIRECT) {
+    file->fd_ = open(file_name.c_str(), O_RDWR | O_DIRECT | create_flags, 0644);
+  } else {
+    file->fd_ = open(file_name.c_str(), O_RDWR | create_flags, 0644);
+  }
+  struct stat stat_buf;
+  if (file->fd_ < 0 || fstat(file->fd_, &stat_buf) != 0) {
+    return nullptr;
+  }
+  file->file_size_ = stat_buf.st_size;
+  return file;
+}
+
+std::shared_ptr<SegmentFile> DiskManager::GetSegmentFile(segment_id_t segment_id) {
+  if (segment_id < 0 || segment_id >= MAX_SEGMENTS) {
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> guard(segment_latch_);
+  return segments_[segment_id];
+}
+
+std::string DiskManager::GetSegmentFileName(segment_id_t segment_id) const {
+  return segment_id == MAIN_SEGMENT ? file_name_ : file_name_ + "." + std::to_string(segment_id);
+}
+
+std::vector<segment_id_t> DiskManager::ReadSegmentList() {
+  std::vector<segment_id_t> segment_ids;
+  const int fd = open(segment_list_name_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return segment_ids;
+  }
+  struct stat stat_buf;
+  if (fstat(fd, &stat_buf) != 0) {
+    close(fd);
+    throw Exception("can't read segment list");
+  }
+  std::vector<segment_id_t> list(stat_buf.st_size / sizeof(segment_id_t));
+  const auto size = static_cast<ssize_t>(list.size() * sizeof(segment_id_t));
+  const bool read_all = pread(fd, list.data(), size, 0) == size;
+  close(fd);
+  if (!read_all || list.empty() || list[0] <= MAIN_SEGMENT || list[0] > MAX_SEGMENTS) {
+    throw Exception("can't read segment list");
+  }
+  next_segment_id_ = list[0];
+  for (size_t i = 1; i < list.size(); i++) {
+    if (list[i] <= MAIN_SEGMENT || list[i] >= next_segment_id_) {
+      throw Exception("can't read segment list");
+    }
+    segment_ids.push_back(list[i]);
+  }
+  return segment_ids;
+}
+
+bool DiskManager::WriteSegmentListLocked() {
+  std::vector<segment_id_t> list{next_segment_id_};
+  for (segment_id_t segment_id = MAIN_SEGMENT + 1; segment_id < next_segment_id_; segment_id++) {
+    if (segments_[segment_id] != nullptr) {
+      list.push_back(segment_id);
+    }
+  }
+  // Write a new list next to the old one and rename it over, so that a crash leaves one of the two.
+  const std::string tmp_name = segment_list_name_ + ".tmp";
+  const int fd = open(tmp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    LOG_DEBUG("can't open segment list");
+    return false;
+  }
+  const auto size = static_cast<ssize_t>(list.size() * sizeof(segment_id_t));
+  bool written = pwrite(fd, list.data(), size, 0) == size;
+  if (written && durability_mode_ != DurabilityMode::NONE) {
+    written = fdatasync(fd) == 0;
+  }
+  close(fd);
+  if (!written || rename(tmp_name.c_str(), segment_list_name_.c_str()) != 0) {
+    LOG_DEBUG("I/O error while writing segment list");
+    unlink(tmp_name.c_str());
+    return false;
+  }
+  return true;
+}
+
+void DiskManager::MapFile() {
+  SegmentFile *main_file = segments_[MAIN_SEGMENT].get();
+  if (main_file->file_size_ == 0) {
+    return;
+  }
+  void *mapping = mmap(nullptr, main_file->file_size_, PROT_READ, MAP_SHARED, main_file->fd_, 0);
+  if (mapping == MAP_FAILED) {
+    throw Exception("can't map db file");
+  }
+  mapping_ = static_cast<char *>(mapping);
+  mapping_size_ = main_file->file_size_;
+}
+
+segment_id_t DiskManager::CreateSegment() {
+  if (io_mode_ == DiskIoMode::MMAP_READ_ONLY) {
+    throw Exception("can't create a segment of a read-only db file");
+  }
+  std::lock_guard<std::mutex> guard(segment_latch_);
+  std::shared_ptr<SegmentFile> file;
+  // A file that is in the way is not ours, e.g. one a crash left behind before it was listed; skip its id.
+  while (file == nullptr) {
+    if (next_segment_id_ == MAX_SEGMENTS) {
+      throw Exception("out of segments");
+    }
+    file = OpenSegmentFile(GetSegmentFileName(next_segment_id_), O_CREAT | O_EXCL);
+    if (file == nullptr && errno != EEXIST) {
+      throw Exception("can't create segment file");
+    }
+    if (file == nullptr) {
+      next_segment_id_++;
+    }
+  }
+  const segment_id_t segment_id = next_segment_id_;
+  segments_[segment_id] = std::move(file);
+  next_segment_id_++;
+  // A file that is not on the list is not part of the database, so list it only once it is there.
+  if (!WriteSegmentListLocked()) {
+    segments_[segment_id] = nullptr;
+    next_segment_id_--;
+    unlink(GetSegmentFileName(segment_id).c_str());
+    throw Exception("can't write segment list");
+  }
+  return segment_id;
+}
+
+void DiskManager::DropSegment(segment_id_t segment_id) {
+  BUSTUB_ASSERT(segment_id != MAIN_SEGMENT, "cannot drop the main segment");
+  std::shared_ptr<SegmentFile> file;
+  {
+    std::lock_guard<std::mutex> guard(segment_latch_);
+    if (segment_id < 0 || segment_id >= MAX_SEGMENTS || segments_[segment_id] == nullptr) {
+      return;
+    }
+    // I/O in flight keeps the file open; it is closed when the last reference goes.
+    file = std::move(segments_[segment_id]);
+    // Take it off the list before the file goes, so that the list never names a file that is not there.
+    if (!WriteSegmentListLocked()) {
+      segments_[segment_id] = std::move(file);
+      return;
+    }
+  }
+  if (unlink(GetSegmentFileName(segment_id).c_str()) != 0) {
+    LOG_DEBUG("can't unlink segment file");
+  }
+}
+
+void DiskManager::TruncateSegment(segment_id_t segment_id) {
+  BUSTUB_ASSERT(segment_id != MAIN_SEGMENT, "cannot truncate the main segment");
+  auto file = GetSegmentFile(segment_id);
+  if (file == nullptr) {
+    return;
+  }
+  if (ftruncate(file->fd_, 0) != 0) {
+    LOG_DEBUG("I/O error while truncating a segment");
+    return;
+  }
+  file->file_size_ = 0;
+  std::lock_guard<std::mutex> guard(extent_latch_);
+  file->next_page_no_ = 0;
+}
+
+size_t DiskManager::GetSegmentFileSize(segment_id_t segment_id) {
+  auto file = GetSegmentFile(segment_id);
+  return file == nullptr ? 0 : file->file_size_.load();
+}
+
+DiskManager::~DiskManager() {
+  delete async_io_;
+  // Frames of a buffer pool may point into the mapping until the end, so it outlives ShutDown.
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+  delete free_page_map_;
+  if (log_sync_.fd_ >= 0) {
+    close(log_sync_.fd_);
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
   {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+    // Wait for the asynchronous requests before the file goes away under them.
+    std::lock_guard<std::mutex> guard(async_io_latch_);
+    delete async_io_;
+    async_io_ = nullptr;
+  }
+  // A clean shutdown is a checkpoint.
+  SyncData();
+  SyncLog();
+  {
+    // Keep the segments, whose sizes can still be asked for, but close their files.
+    std::lock_guard<std::mutex> guard(segment_latch_);
+    for (auto &file : segments_) {
+      if (file != nullptr && file->fd_ >= 0) {
+        close(file->fd_);
+        file->fd_ = -1;
+      }
+    }
+  }
+  if (log_sync_.fd_ >= 0) {
+    close(log_sync_.fd_);
+    log_sync_.fd_ = -1;
   }
   log_io_.close();
 }
@@ -85,47 +390,486 @@ void DiskManager::ShutDown() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * PAGE_SIZE;
-  // set write cursor to offset
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
+  if (io_mode_ == DiskIoMode::MMAP_READ_ONLY) {
+    LOG_DEBUG("dropping a write to a read-only db file");
+    return;
+  }
+  if (io_mode_ == DiskIoMode::DIRECT && !IsAligned(&page_data, 1)) {
+    WritePagesAt(page_id, &page_data, 1);
+    return;
+  }
+  auto file = GetSegmentFile(GetSegmentId(page_id));
+  if (file == nullptr) {
+    // The buffer pool discards the pages of a segment before it is dropped, so the page would be lost.
+    throw Exception("write to a page of a dropped segment");
+  }
+  const off_t offset = GetPageOffset(page_id);
+  if (!PwriteAll(file->fd_, page_data, PAGE_SIZE, offset)) {
     LOG_DEBUG("I/O error while writing");
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  WroteData(file.get(), offset + PAGE_SIZE);
+}
+
+/**
+ * Write a run of consecutive pages with pwritev, IOV_MAX pages at a time
+ */
+void DiskManager::WritePages(page_id_t first_page_id, const char *const *page_data, size_t num_pages) {
+  num_writes_ += num_pages;
+  WritePagesAt(first_page_id, page_data, num_pages);
+}
+
+void DiskManager::WritePagesAt(page_id_t first_page_id, const char *const *page_data, size_t num_pages) {
+  if (io_mode_ == DiskIoMode::MMAP_READ_ONLY) {
+    LOG_DEBUG("dropping a write to a read-only db file");
+    return;
+  }
+  if (io_mode_ == DiskIoMode::DIRECT && !IsAligned(page_data, num_pages)) {
+    // O_DIRECT rejects buffers that are not aligned, so write aligned copies.
+    AlignedPageBuffer buffer(num_pages);
+    std::vector<const char *> copies(num_pages);
+    for (size_t i = 0; i < num_pages; i++) {
+      copies[i] = buffer.GetPage(i);
+      memcpy(buffer.GetPage(i), page_data[i], PAGE_SIZE);
+    }
+    WritePagesAt(first_page_id, copies.data(), num_pages);
+    return;
+  }
+  const size_t pages_in_segment = GetPagesInSegment(first_page_id, num_pages);
+  if (pages_in_segment < num_pages) {
+    // Each segment is a file of its own, so write the run one segment at a time.
+    WritePagesAt(first_page_id, page_data, pages_in_segment);
+    WritePagesAt(first_page_id + static_cast<page_id_t>(pages_in_segment), page_data + pages_in_segment,
+                 num_pages - pages_in_segment);
+    return;
+  }
+  auto file = GetSegmentFile(GetSegmentId(first_page_id));
+  if (file == nullptr) {
+    throw Exception("write to a page of a dropped segment");
+  }
+  std::vector<iovec> iovs(std::min<size_t>(num_pages, IOV_MAX));
+  size_t done = 0;
+  while (done < num_pages) {
+    size_t batch = std::min<size_t>(num_pages - done, IOV_MAX);
+    for (size_t i = 0; i < batch; i++) {
+      iovs[i].iov_base = const_cast<char *>(page_data[done + i]);
+      iovs[i].iov_len = PAGE_SIZE;
+    }
+    off_t offset = GetPageOffset(first_page_id + static_cast<page_id_t>(done));
+    iovec *iov = iovs.data();
+    int iovcnt = static_cast<int>(batch);
+    while (iovcnt > 0) {
+      ssize_t written = pwritev(file->fd_, iov, iovcnt, offset);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        LOG_DEBUG("I/O error while writing");
+        return;
+      }
+      offset += written;
+      AdvanceIovecs(&iov, &iovcnt, written);
+    }
+    WroteData(file.get(), offset);
+    done += batch;
+  }
+}
+
+/**
+ * Read a run of consecutive pages with preadv, IOV_MAX pages at a time
+ */
+void DiskManager::ReadPages(page_id_t first_page_id, char *const *page_data, size_t num_pages) {
+  ReadPagesAt(first_page_id, page_data, num_pages);
+}
+
+void DiskManager::ReadPagesAt(page_id_t first_page_id, char *const *page_data, size_t num_pages) {
+  const size_t pages_in_segment = GetPagesInSegment(first_page_id, num_pages);
+  if (pages_in_segment < num_pages) {
+    // Each segment is a file of its own, so read the run one segment at a time.
+    ReadPagesAt(first_page_id, page_data, pages_in_segment);
+    ReadPagesAt(first_page_id + static_cast<page_id_t>(pages_in_segment), page_data + pages_in_segment,
+                num_pages - pages_in_segment);
+    return;
+  }
+  if (io_mode_ == DiskIoMode::MMAP_READ_ONLY && GetSegmentId(first_page_id) == MAIN_SEGMENT) {
+    ReadMappedPages(first_page_id, page_data, num_pages);
+    return;
+  }
+  if (io_mode_ == DiskIoMode::DIRECT && !IsAligned(page_data, num_pages)) {
+    // O_DIRECT rejects buffers that are not aligned, so read into aligned copies.
+    AlignedPageBuffer buffer(num_pages);
+    std::vector<char *> copies(num_pages);
+    for (size_t i = 0; i < num_pages; i++) {
+      copies[i] = buffer.GetPage(i);
+    }
+    ReadPagesAt(first_page_id, copies.data(), num_pages);
+    for (size_t i = 0; i < num_pages; i++) {
+      memcpy(page_data[i], copies[i], PAGE_SIZE);
+    }
+    return;
+  }
+  auto file = GetSegmentFile(GetSegmentId(first_page_id));
+  if (file == nullptr) {
+    // A dropped segment reads as zeros, like a page that was never written.
+    for (size_t i = 0; i < num_pages; i++) {
+      memset(page_data[i], 0, PAGE_SIZE);
+    }
+    return;
+  }
+  std::vector<iovec> iovs(std::min<size_t>(num_pages, IOV_MAX));
+  size_t done = 0;
+  while (done < num_pages) {
+    size_t batch = std::min<size_t>(num_pages - done, IOV_MAX);
+    for (size_t i = 0; i < batch; i++) {
+      iovs[i].iov_base = page_data[done + i];
+      iovs[i].iov_len = PAGE_SIZE;
+    }
+    off_t offset = GetPageOffset(first_page_id + static_cast<page_id_t>(done));
+    iovec *iov = iovs.data();
+    int iovcnt = static_cast<int>(batch);
+    while (iovcnt > 0) {
+      // Nothing has been written past the end of the file yet.
+      ssize_t read_count =
+          offset < static_cast<off_t>(file->file_size_.load()) ? preadv(file->fd_, iov, iovcnt, offset) : 0;
+      if (read_count < 0 && errno == EINTR) {
+        continue;
+      }
+      if (read_count <= 0) {
+        if (read_count < 0) {
+          LOG_DEBUG("I/O error while reading");
+        }
+        for (; iovcnt > 0; iov++, iovcnt--) {
+          memset(iov->iov_base, 0, iov->iov_len);
+        }
+        break;
+      }
+      offset += read_count;
+      AdvanceIovecs(&iov, &iovcnt, read_count);
+    }
+    done += batch;
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * PAGE_SIZE;
+  if (io_mode_ == DiskIoMode::MMAP_READ_ONLY || (io_mode_ == DiskIoMode::DIRECT && !IsAligned(&page_data, 1))) {
+    ReadPagesAt(page_id, &page_data, 1);
+    return;
+  }
+  auto file = GetSegmentFile(GetSegmentId(page_id));
+  const off_t offset = GetPageOffset(page_id);
   // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
+  if (file == nullptr || offset >= static_cast<off_t>(file->file_size_.load())) {
     LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, PAGE_SIZE);
-    if (db_io_.bad()) {
+    memset(page_data, 0, PAGE_SIZE);
+    return;
+  }
+  size_t read_count = 0;
+  while (read_count < PAGE_SIZE) {
+    ssize_t n = pread(file->fd_, page_data + read_count, PAGE_SIZE - read_count, offset + read_count);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
       LOG_DEBUG("I/O error while reading");
       return;
     }
-    // if file ends before reading PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+    if (n == 0) {
+      break;
+    }
+    read_count += n;
+  }
+  // if file ends before reading PAGE_SIZE
+  if (read_count < PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, PAGE_SIZE - read_count);
+  }
+}
+
+void DiskManager::ReadMappedPages(page_id_t first_page_id, char *const *page_data, size_t num_pages) {
+  for (size_t i = 0; i < num_pages; i++) {
+    // Not through a subclass, which may hide the mapping from the buffer pool and read through here instead.
+    const char *mapped = DiskManager::GetMappedPage(first_page_id + static_cast<page_id_t>(i));
+    if (mapped != nullptr) {
+      memcpy(page_data[i], mapped, PAGE_SIZE);
+    } else {
+      memset(page_data[i], 0, PAGE_SIZE);
+    }
+  }
+}
+
+const char *DiskManager::GetMappedPage(page_id_t page_id) const {
+  auto offset = static_cast<size_t>(page_id) * PAGE_SIZE;
+  // A partial page at the end of the file is not served from the mapping, whose tail past the file would fault. Only
+  // the main segment is mapped, and its page offsets are the page ids times PAGE_SIZE.
+  if (mapping_ == nullptr || page_id < 0 || GetSegmentId(page_id) != MAIN_SEGMENT ||
+      offset + PAGE_SIZE > mapping_size_) {
+    return nullptr;
+  }
+  return mapping_ + offset;
+}
+
+void DiskManager::AdviseAccess(AccessPattern pattern, segment_id_t segment_id) {
+  int advice = MADV_NORMAL;
+  int fadvice = POSIX_FADV_NORMAL;
+  switch (pattern) {
+    case AccessPattern::NORMAL:
+      break;
+    case AccessPattern::SEQUENTIAL:
+      advice = MADV_SEQUENTIAL;
+      fadvice = POSIX_FADV_SEQUENTIAL;
+      break;
+    case AccessPattern::RANDOM:
+      advice = MADV_RANDOM;
+      fadvice = POSIX_FADV_RANDOM;
+      break;
+  }
+  if (mapping_ != nullptr && segment_id == MAIN_SEGMENT) {
+    madvise(mapping_, mapping_size_, advice);
+  }
+  auto file = GetSegmentFile(segment_id);
+  if (file != nullptr && file->fd_ >= 0) {
+    posix_fadvise(file->fd_, 0, 0, fadvice);
+  }
+}
+
+void DiskManager::AdviseWillNeed(page_id_t first_page_id, size_t num_pages) {
+  const segment_id_t segment_id = GetSegmentId(first_page_id);
+  const off_t offset = GetPageOffset(first_page_id);
+  num_pages = GetPagesInSegment(first_page_id, num_pages);
+  if (mapping_ != nullptr && segment_id == MAIN_SEGMENT) {
+    if (static_cast<size_t>(offset) < mapping_size_) {
+      // madvise wants a page-aligned start; PAGE_SIZE is a multiple of the OS page size.
+      madvise(mapping_ + offset, std::min(num_pages * PAGE_SIZE, mapping_size_ - offset), MADV_WILLNEED);
     }
+    return;
+  }
+  auto file = GetSegmentFile(segment_id);
+  if (file != nullptr && file->fd_ >= 0) {
+    posix_fadvise(file->fd_, offset, num_pages * PAGE_SIZE, POSIX_FADV_WILLNEED);
+  }
+}
+
+std::future<void> DiskManager::ReadyFuture() {
+  std::promise<void> promise;
+  promise.set_value();
+  return promise.get_future();
+}
+
+/**
+ * Hand a write of a run of consecutive pages to the async I/O backend
+ */
+std::future<void> DiskManager::WritePagesAsync(page_id_t first_page_id, const char *const *page_data,
+                                               size_t num_pages) {
+  num_writes_ += num_pages;
+  auto file = GetSegmentFile(GetSegmentId(first_page_id));
+  // A request goes to one file; a run across segments is rare enough to do synchronously.
+  if (io_mode_ == DiskIoMode::MMAP_READ_ONLY || file == nullptr ||
+      GetPagesInSegment(first_page_id, num_pages) < num_pages) {
+    WritePagesAt(first_page_id, page_data, num_pages);
+    return ReadyFuture();
+  }
+  auto *request = new AsyncIoRequest();
+  request->write_ = true;
+  request->first_page_id_ = first_page_id;
+  request->file_ = std::move(file);
+  for (size_t i = 0; i < num_pages; i++) {
+    request->page_data_.push_back(const_cast<char *>(page_data[i]));
+  }
+  std::future<void> future = request->promise_.get_future();
+  std::shared_ptr<SegmentFile> written_file = request->file_;
+  GetAsyncIo()->Submit(request);
+  if (durability_mode_ == DurabilityMode::SYNC_EACH_WRITE) {
+    // The write counts as done once it is synced. The backend does not sync, as the io_uring reaper would hold up all
+    // other completions of the ring meanwhile; the sync runs in the thread that waits, batched with the other writers.
+    return std::async(std::launch::deferred, [this, file = std::move(written_file), written = std::move(future)] {
+      written.wait();
+      Sync(&file->sync_, file.get());
+    });
+  }
+  return future;
+}
+
+/**
+ * Hand a read of a run of consecutive pages to the async I/O backend
+ */
+std::future<void> DiskManager::ReadPagesAsync(page_id_t first_page_id, char *const *page_data, size_t num_pages) {
+  // Copying out of the mapping takes less time than handing the request to another thread.
+  if (io_mode_ == DiskIoMode::MMAP_READ_ONLY && GetSegmentId(first_page_id) == MAIN_SEGMENT) {
+    ReadPagesAt(first_page_id, page_data, num_pages);
+    return ReadyFuture();
+  }
+  auto file = GetSegmentFile(GetSegmentId(first_page_id));
+  if (file == nullptr || GetPagesInSegment(first_page_id, num_pages) < num_pages) {
+    ReadPagesAt(first_page_id, page_data, num_pages);
+    return ReadyFuture();
+  }
+  auto *request = new AsyncIoRequest();
+  request->write_ = false;
+  request->first_page_id_ = first_page_id;
+  request->file_ = std::move(file);
+  request->page_data_.assign(page_data, page_data + num_pages);
+  std::future<void> future = request->promise_.get_future();
+  GetAsyncIo()->Submit(request);
+  return future;
+}
+
+AsyncIoBackend *DiskManager::GetAsyncIo() {
+  std::lock_guard<std::mutex> guard(async_io_latch_);
+  if (async_io_ == nullptr) {
+    async_io_ = AsyncIoBackend::Create(async_io_type_, this);
+  }
+  return async_io_;
+}
+
+AsyncIoType DiskManager::GetAsyncIoType() { return GetAsyncIo()->GetType(); }
+
+/**
+ * Make the page writes that are done so far durable
+ */
+void DiskManager::SyncData() {
+  if (free_page_map_ != nullptr) {
+    free_page_map_->Flush();
+  }
+  if (durability_mode_ != DurabilityMode::NONE) {
+    Sync(&data_sync_);
+  }
+}
+
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  // The pages of the other segments come back with their files.
+  if (GetSegmentId(page_id) == MAIN_SEGMENT) {
+    free_page_map_->Free(page_id);
+  }
+}
+
+page_id_t DiskManager::AllocateFreePage(page_id_t limit, uint32_t stride, uint32_t offset) {
+  return free_page_map_->Allocate(limit, stride, offset);
+}
+
+bool DiskManager::ReservePage(page_id_t page_id) {
+  if (GetSegmentId(page_id) != MAIN_SEGMENT) {
+    throw Exception("page id past the end of the main segment");
+  }
+  {
+    std::lock_guard<std::mutex> guard(extent_latch_);
+    auto it = extents_.upper_bound(page_id);
+    if (it != extents_.begin() && (--it)->second >= page_id) {
+      return false;
+    }
+    max_page_id_ = std::max(max_page_id_, page_id);
+  }
+  free_page_map_->Reserve(page_id);
+  return true;
+}
+
+page_id_t DiskManager::AllocateExtent(size_t num_pages, segment_id_t segment_id) {
+  BUSTUB_ASSERT(num_pages > 0, "an extent has at least one page");
+  std::lock_guard<std::mutex> guard(extent_latch_);
+  const auto size = static_cast<page_id_t>(num_pages);
+  if (segment_id != MAIN_SEGMENT) {
+    // The segment is only used by extents, so there is nothing to keep track of but where the next one starts.
+    auto file = GetSegmentFile(segment_id);
+    if (file == nullptr) {
+      throw Exception("no such segment");
+    }
+    const size_t first_page_no = (file->next_page_no_ + num_pages - 1) / num_pages * num_pages;
+    if (first_page_no + num_pages > SEGMENT_MAX_PAGES) {
+      throw Exception("segment is full");
+    }
+    file->next_page_no_ = first_page_no + num_pages;
+    return GetFirstPageId(segment_id) + static_cast<page_id_t>(first_page_no);
+  }
+  const page_id_t first_page_id = (max_page_id_ + size) / size * size;
+  if (static_cast<size_t>(first_page_id) + num_pages > SEGMENT_MAX_PAGES) {
+    throw Exception("main segment is full");
+  }
+  const page_id_t last_page_id = first_page_id + size - 1;
+  extents_.emplace(first_page_id, last_page_id);
+  max_page_id_ = last_page_id;
+  for (page_id_t page_id = first_page_id; page_id <= last_page_id; page_id++) {
+    free_page_map_->Reserve(page_id);
+  }
+  return first_page_id;
+}
+
+size_t DiskManager::GetNumFreePages() const { return free_page_map_->GetNumFreePages(); }
+
+/**
+ * Make the log writes that are done so far durable
+ */
+void DiskManager::SyncLog() {
+  if (durability_mode_ != DurabilityMode::NONE) {
+    Sync(&log_sync_);
+  }
+}
+
+void DiskManager::Sync(SyncState *state, SegmentFile *file) {
+  const uint64_t target = state->write_seq_;
+  std::unique_lock<std::mutex> guard(state->latch_);
+  // If a sync is going on, it may have started before our writes were done. Wait for it and check again; by then one
+  // of the waiters starts a sync that covers all of them.
+  while (state->synced_seq_ < target) {
+    if (state->syncing_) {
+      state->cv_.wait(guard);
+      continue;
+    }
+    state->syncing_ = true;
+    const uint64_t seq = state->write_seq_;
+    guard.unlock();
+    const int fd = file != nullptr ? file->fd_ : state->fd_;
+    bool synced = state == &data_sync_ ? SyncSegmentFiles() : (fd >= 0 && fdatasync(fd) == 0);
+    if (state != &data_sync_) {
+      num_syncs_ += 1;
+    }
+    guard.lock();
+    state->syncing_ = false;
+    state->cv_.notify_all();
+    if (!synced) {
+      LOG_DEBUG("I/O error while syncing");
+      return;
+    }
+    state->synced_seq_ = std::max(state->synced_seq_, seq);
+  }
+}
+
+bool DiskManager::SyncSegmentFiles() {
+  std::vector<std::shared_ptr<SegmentFile>> files;
+  {
+    std::lock_guard<std::mutex> guard(segment_latch_);
+    for (const auto &file : segments_) {
+      if (file != nullptr) {
+        files.push_back(file);
+      }
+    }
+  }
+  bool synced = !files.empty();
+  for (const auto &file : files) {
+    synced = file->fd_ >= 0 && fdatasync(file->fd_) == 0 && synced;
+    num_syncs_ += 1;
+  }
+  return synced;
+}
+
+void DiskManager::WroteData(SegmentFile *file, size_t end_offset, bool sync) {
+  GrowFileSize(file, end_offset);
+  if (durability_mode_ == DurabilityMode::SYNC_EACH_WRITE) {
+    // Only the file written to has anything to sync. Nothing is left for a checkpoint to do.
+    file->sync_.write_seq_++;
+    if (sync) {
+      Sync(&file->sync_, file);
+    }
+  } else {
+    data_sync_.write_seq_++;
+  }
+}
+
+void DiskManager::GrowFileSize(SegmentFile *file, size_t size) {
+  size_t file_size = file->file_size_.load();
+  while (file_size < size && !file->file_size_.compare_exchange_weak(file_size, size)) {
   }
 }
 
@@ -160,6 +904,10 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
   // needs to flush to keep disk file in sync
   log_io_.flush();
+  log_sync_.write_seq_++;
+  if (durability_mode_ == DurabilityMode::SYNC_EACH_WRITE) {
+    Sync(&log_sync_);
+  }
   flush_log_ = false;
 }
 
@@ -201,6 +949,18 @@ int DiskManager::GetNumFlushes() const { return num_flushes_; }
  */
 int DiskManager::GetNumWrites() const { return num_writes_; }
 
+/**
+ * Returns the size of the db file
+ */
+size_t DiskManager::GetDbFileSize() const {
+  return segments_[MAIN_SEGMENT] == nullptr ? 0 : segments_[MAIN_SEGMENT]->file_size_.load();
+}
+
+/**
+ * Returns the number of fdatasync calls on the db and log files
+ */
+int DiskManager::GetNumSyncs() const { return num_syncs_; }
+
 /**
  * Returns true if the log is currently being flushed
  */
@@ -0,0 +1,217 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map.cpp
+//
+// Identification: src/storage/disk/free_page_map.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/free_page_map.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include "common/logger.h"
+
+namespace bustub {
+
+static constexpr size_t WORDS_PER_PAGE = FreePageMap::BITS_PER_PAGE / 64;
+
+FreePageMap::FreePageMap(std::string file_name, bool reset, bool sync)
+    : file_name_(std::move(file_name)), sync_(sync) {
+  if (reset) {
+    // A map left behind by an earlier database file of the same name says nothing about this one.
+    unlink(file_name_.c_str());
+    return;
+  }
+  fd_ = open(file_name_.c_str(), O_RDWR);
+  if (fd_ < 0) {
+    return;
+  }
+  struct stat stat_buf;
+  if (fstat(fd_, &stat_buf) != 0) {
+    return;
+  }
+  size_t num_pages = stat_buf.st_size / PAGE_SIZE;
+  words_.resize(num_pages * WORDS_PER_PAGE);
+  size_t size = num_pages * PAGE_SIZE;
+  auto *data = reinterpret_cast<char *>(words_.data());
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = pread(fd_, data + done, size - done, done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      LOG_DEBUG("I/O error while reading the free page map");
+      words_.clear();
+      return;
+    }
+    done += n;
+  }
+  size_t num_free = 0;
+  for (uint64_t word : words_) {
+    num_free += __builtin_popcountll(word);
+  }
+  num_free_ = num_free;
+}
+
+FreePageMap::~FreePageMap() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+void FreePageMap::Free(page_id_t page_id) {
+  BUSTUB_ASSERT(page_id >= 0, "cannot free an invalid page");
+  std::lock_guard<std::mutex> guard(latch_);
+  size_t word = page_id / 64;
+  uint64_t bit = uint64_t{1} << (page_id % 64);
+  if (word >= words_.size()) {
+    // Grow by whole bitmap pages, so that every page in memory has its place in the file.
+    words_.resize((word / WORDS_PER_PAGE + 1) * WORDS_PER_PAGE);
+  }
+  if ((words_[word] & bit) != 0) {
+    return;
+  }
+  words_[word] |= bit;
+  dirty_pages_.insert(word / WORDS_PER_PAGE);
+  num_free_++;
+  for (auto &[stride, partition] : partitions_) {
+    const size_t offset = page_id % stride;
+    partition.num_free_[offset]++;
+    partition.first_word_[offset] = std::min(partition.first_word_[offset], word);
+  }
+}
+
+page_id_t FreePageMap::Allocate(page_id_t limit, uint32_t stride, uint32_t offset) {
+  if (num_free_ == 0) {
+    return INVALID_PAGE_ID;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  Partition &partition = GetPartitionLocked(stride);
+  if (partition.num_free_[offset] == 0) {
+    return INVALID_PAGE_ID;
+  }
+  size_t end = std::min(words_.size(), (static_cast<size_t>(limit) + 63) / 64);
+  size_t &first_word = partition.first_word_[offset];
+  for (; first_word < end; first_word++) {
+    // Look at the set bits only.
+    for (uint64_t bits = words_[first_word]; bits != 0; bits &= bits - 1) {
+      size_t page_id = first_word * 64 + __builtin_ctzll(bits);
+      if (page_id >= static_cast<size_t>(limit)) {
+        return INVALID_PAGE_ID;
+      }
+      if (page_id % stride == offset) {
+        ClearLocked(page_id);
+        return static_cast<page_id_t>(page_id);
+      }
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+FreePageMap::Partition &FreePageMap::GetPartitionLocked(uint32_t stride) {
+  auto it = partitions_.find(stride);
+  if (it != partitions_.end()) {
+    return it->second;
+  }
+  Partition &partition = partitions_[stride];
+  partition.num_free_.resize(stride, 0);
+  partition.first_word_.resize(stride, words_.size());
+  for (size_t word = 0; word < words_.size(); word++) {
+    for (uint64_t bits = words_[word]; bits != 0; bits &= bits - 1) {
+      const size_t offset = (word * 64 + __builtin_ctzll(bits)) % stride;
+      partition.num_free_[offset]++;
+      partition.first_word_[offset] = std::min(partition.first_word_[offset], word);
+    }
+  }
+  return partition;
+}
+
+void FreePageMap::Reserve(page_id_t page_id) {
+  if (num_free_ == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(latch_);
+  size_t word = page_id / 64;
+  if (word < words_.size() && (words_[word] & (uint64_t{1} << (page_id % 64))) != 0) {
+    ClearLocked(page_id);
+  }
+}
+
+void FreePageMap::ClearLocked(size_t page_id) {
+  words_[page_id / 64] &= ~(uint64_t{1} << (page_id % 64));
+  num_free_--;
+  for (auto &[stride, partition] : partitions_) {
+    partition.num_free_[page_id % stride]--;
+  }
+  // The page is in use from now on. If the file still had it as free after a crash, it would be handed out twice.
+  const size_t page = page_id / BITS_PER_PAGE;
+  if (!OpenLocked() || !WritePageLocked(page)) {
+    LOG_DEBUG("I/O error while writing the free page map");
+    dirty_pages_.insert(page);
+    return;
+  }
+  dirty_pages_.erase(page);
+  if (sync_ && fdatasync(fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing the free page map");
+  }
+}
+
+bool FreePageMap::OpenLocked() {
+  if (fd_ < 0) {
+    fd_ = open(file_name_.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  return fd_ >= 0;
+}
+
+bool FreePageMap::WritePageLocked(size_t page) {
+  const auto *data = reinterpret_cast<const char *>(words_.data() + page * WORDS_PER_PAGE);
+  size_t done = 0;
+  while (done < PAGE_SIZE) {
+    ssize_t n = pwrite(fd_, data + done, PAGE_SIZE - done, page * PAGE_SIZE + done);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      return false;
+    }
+    done += n;
+  }
+  return true;
+}
+
+void FreePageMap::Flush() {
+  std::lock_guard<std::mutex> guard(latch_);
+  if (dirty_pages_.empty()) {
+    return;
+  }
+  if (!OpenLocked()) {
+    LOG_DEBUG("can't open the free page map file");
+    return;
+  }
+  for (size_t page : dirty_pages_) {
+    if (!WritePageLocked(page)) {
+      // Keep the pages dirty, to try again on the next flush.
+      LOG_DEBUG("I/O error while writing the free page map");
+      return;
+    }
+  }
+  dirty_pages_.clear();
+  if (sync_ && fdatasync(fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing the free page map");
+  }
+}
+
+}  // namespace bustub
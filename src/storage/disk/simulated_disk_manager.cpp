@@ -0,0 +1,115 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// simulated_disk_manager.cpp
+//
+// Identification: src/storage/disk/simulated_disk_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/simulated_disk_manager.h"
+
+#include <algorithm>
+#include <thread>  // NOLINT
+#include <utility>
+
+namespace bustub {
+
+SimulatedDiskManager::SimulatedDiskManager(const std::string &db_file, const SimulatedDiskConfig &config,
+                                           AsyncIoType async_io_type, DurabilityMode durability_mode,
+                                           DiskIoMode io_mode)
+    : DiskManager(db_file, async_io_type, durability_mode, io_mode),
+      config_(config),
+      slots_(std::max<size_t>(config.queue_depth_, 1)) {}
+
+SimulatedDiskManager::Clock::time_point SimulatedDiskManager::Schedule(bool write, size_t num_pages, bool async) {
+  const Clock::time_point now = Clock::now();
+  std::lock_guard<std::mutex> guard(latch_);
+  // The request takes the slot that frees up first, then transfers once its latency is over and the transfers
+  // scheduled before it are done.
+  auto slot = std::min_element(slots_.begin(), slots_.end());
+  const Clock::time_point start = std::max(now, *slot);
+  Clock::time_point done = start + (write ? config_.write_latency_ : config_.read_latency_);
+  if (config_.bandwidth_ > 0) {
+    std::chrono::duration<double> transfer(static_cast<double>(num_pages * PAGE_SIZE) / config_.bandwidth_);
+    done = std::max(done, transfer_free_) + std::chrono::duration_cast<Clock::duration>(transfer);
+    transfer_free_ = done;
+  }
+  *slot = done;
+
+  if (write) {
+    counters_.writes_++;
+    counters_.pages_written_ += num_pages;
+    counters_.async_writes_ += async ? 1 : 0;
+  } else {
+    counters_.reads_++;
+    counters_.pages_read_ += num_pages;
+    counters_.async_reads_ += async ? 1 : 0;
+  }
+  counters_.queued_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(start - now).count();
+  counters_.service_ns_ += std::chrono::duration_cast<std::chrono::nanoseconds>(done - start).count();
+  return done;
+}
+
+void SimulatedDiskManager::WritePage(page_id_t page_id, const char *page_data) {
+  const Clock::time_point done = Schedule(true, 1, false);
+  DiskManager::WritePage(page_id, page_data);
+  std::this_thread::sleep_until(done);
+}
+
+void SimulatedDiskManager::WritePages(page_id_t first_page_id, const char *const *page_data, size_t num_pages) {
+  const Clock::time_point done = Schedule(true, num_pages, false);
+  DiskManager::WritePages(first_page_id, page_data, num_pages);
+  std::this_thread::sleep_until(done);
+}
+
+void SimulatedDiskManager::ReadPage(page_id_t page_id, char *page_data) {
+  const Clock::time_point done = Schedule(false, 1, false);
+  DiskManager::ReadPage(page_id, page_data);
+  std::this_thread::sleep_until(done);
+}
+
+void SimulatedDiskManager::ReadPages(page_id_t first_page_id, char *const *page_data, size_t num_pages) {
+  const Clock::time_point done = Schedule(false, num_pages, false);
+  DiskManager::ReadPages(first_page_id, page_data, num_pages);
+  std::this_thread::sleep_until(done);
+}
+
+/**
+ * The request runs on the real disk right away. Its future waits for it, and then for the simulated device, when the
+ * caller waits, so that no thread is needed to make it ready at the right time.
+ */
+std::future<void> SimulatedDiskManager::WritePagesAsync(page_id_t first_page_id, const char *const *page_data,
+                                                        size_t num_pages) {
+  const Clock::time_point done = Schedule(true, num_pages, true);
+  std::future<void> write = DiskManager::WritePagesAsync(first_page_id, page_data, num_pages);
+  return std::async(std::launch::deferred, [write = std::move(write), done] {
+    write.wait();
+    std::this_thread::sleep_until(done);
+  });
+}
+
+std::future<void> SimulatedDiskManager::ReadPagesAsync(page_id_t first_page_id, char *const *page_data,
+                                                       size_t num_pages) {
+  const Clock::time_point done = Schedule(false, num_pages, true);
+  std::future<void> read = DiskManager::ReadPagesAsync(first_page_id, page_data, num_pages);
+  return std::async(std::launch::deferred, [read = std::move(read), done] {
+    read.wait();
+    std::this_thread::sleep_until(done);
+  });
+}
+
+DiskIoCounters SimulatedDiskManager::GetIoCounters() {
+  std::lock_guard<std::mutex> guard(latch_);
+  return counters_;
+}
+
+void SimulatedDiskManager::ResetIoCounters() {
+  std::lock_guard<std::mutex> guard(latch_);
+  counters_ = DiskIoCounters();
+}
+
+}  // namespace bustub
@@ -38,7 +38,7 @@ size_t HASH_TABLE_BUCKET_TYPE::BitCount(uint32_t byte_char) const {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) {
+bool HASH_TABLE_BUCKET_TYPE::GetValue(KeyType key, KeyComparator cmp, std::vector<ValueType> *result) const {
   for (size_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
     if (IsReadable(i) && !cmp(key, array_[i].first)) {
       result->push_back(array_[i].second);
@@ -142,14 +142,14 @@ void HASH_TABLE_BUCKET_TYPE::SetReadable(uint32_t bucket_idx) {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_BUCKET_TYPE::IsFull() {
+bool HASH_TABLE_BUCKET_TYPE::IsFull() const {
   auto is_zero = [](char byte_char) -> bool { return byte_char == 0x11; };
   auto len = sizeof(readable_) / sizeof(char);
   return std::all_of(readable_, readable_ + len, is_zero);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-uint32_t HASH_TABLE_BUCKET_TYPE::NumReadable() {
+uint32_t HASH_TABLE_BUCKET_TYPE::NumReadable() const {
   uint32_t cnt = 0;
   for (size_t i = 0; i < BUCKET_ARRAY_SIZE; i++) {
     if (IsReadable(i)) {
@@ -160,7 +160,7 @@ uint32_t HASH_TABLE_BUCKET_TYPE::NumReadable() {
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_BUCKET_TYPE::IsEmpty() {
+bool HASH_TABLE_BUCKET_TYPE::IsEmpty() const {
   uint8_t mask = 255;
   for (size_t i = 0; i < sizeof(readable_) / sizeof(readable_[0]); i++) {
     if ((readable_[i] & mask) > 0) {
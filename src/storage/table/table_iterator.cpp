@@ -10,16 +10,19 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), strategy_(strategy) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_, strategy_);
+    ReadAhead(rid.GetPageId(), INVALID_PAGE_ID);
   }
 }
 
@@ -35,19 +38,19 @@ Tuple *TableIterator::operator->() {
 
 TableIterator &TableIterator::operator++() {
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  cur_page->RLatch();
-  assert(cur_page != nullptr);  // all pages are pinned
+  auto cur_guard = buffer_pool_manager->FetchPageRead(tuple_->rid_.GetPageId(), strategy_);
+  assert(cur_guard.IsValid());  // all pages are pinned
+  auto cur_page = cur_guard.AsPage<TablePage>();
 
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+      auto next_guard = buffer_pool_manager->FetchPageBasic(cur_page->GetNextPageId(), strategy_);
+      cur_guard.Drop();
+      cur_guard = next_guard.UpgradeRead();
+      cur_page = cur_guard.AsPage<TablePage>();
+      ReadAhead(cur_page->GetTablePageId(), cur_page->GetNextPageId());
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -56,14 +59,42 @@ TableIterator &TableIterator::operator++() {
   tuple_->rid_ = next_tuple_rid;
 
   if (*this != table_heap_->End()) {
-    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_);
+    table_heap_->GetTuple(tuple_->rid_, tuple_, txn_, strategy_);
   }
   // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
   return *this;
 }
 
+void TableIterator::ReadAhead(page_id_t page_id, page_id_t next_page_id) {
+  const auto window = static_cast<page_id_t>(table_heap_->read_ahead_pages_);
+  if (strategy_ != nullptr || window == 0) {
+    return;  // prefetched pages would land outside the ring
+  }
+  // Without the next page, stay in the extent of this one: the ids past it may belong to someone else. Ids past the end
+  // of the heap in its own extent are read as zeros, and a page created there later takes over the frame.
+  page_id_t first = page_id + 1;
+  page_id_t extent_page_id = page_id;
+  if (next_page_id != INVALID_PAGE_ID) {
+    first = next_page_id;
+    extent_page_id = next_page_id;
+  }
+  const auto extent_size = static_cast<page_id_t>(table_heap_->extent_.GetExtentSize());
+  const page_id_t end = std::min(extent_page_id / extent_size * extent_size + extent_size, first + window);
+  // Skip the pages an earlier call prefetched.
+  if (readahead_page_id_ >= first && readahead_page_id_ < end) {
+    first = readahead_page_id_ + 1;
+  }
+  if (first >= end) {
+    return;
+  }
+  std::vector<page_id_t> page_ids;
+  for (page_id_t prefetch_page_id = first; prefetch_page_id < end; prefetch_page_id++) {
+    page_ids.push_back(prefetch_page_id);
+  }
+  table_heap_->buffer_pool_manager_->PrefetchPages(page_ids);
+  readahead_page_id_ = end - 1;
+}
+
 TableIterator TableIterator::operator++(int) {
   TableIterator clone(*this);
   ++(*this);
@@ -0,0 +1,201 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy_test.cpp
+//
+// Identification: test/buffer/buffer_access_strategy_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "concurrency/transaction.h"
+#include "db_file_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class BufferAccessStrategyTest : public DbFileTest {};
+
+// The slots of a ring are handed out in turn, separately for each instance of a parallel buffer pool.
+// NOLINTNEXTLINE
+TEST_F(BufferAccessStrategyTest, NextSlotTest) {
+  BufferAccessStrategy strategy(4);
+  // Each instance gets half the ring.
+  BufferAccessStrategy::Slot *first = strategy.NextSlot(0, 2);
+  EXPECT_EQ(-1, first->frame_id_);
+  first->frame_id_ = 10;
+  BufferAccessStrategy::Slot *second = strategy.NextSlot(0, 2);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(-1, second->frame_id_);
+  second->frame_id_ = 11;
+  EXPECT_EQ(first, strategy.NextSlot(0, 2));
+  EXPECT_EQ(-1, strategy.NextSlot(1, 2)->frame_id_);
+  EXPECT_EQ(second, strategy.NextSlot(0, 2));
+}
+
+// A scan through a ring reuses the ring's frames and leaves the rest of the pool alone.
+// NOLINTNEXTLINE
+TEST_F(BufferAccessStrategyTest, RingTest) {
+  const size_t pool_size = 16;
+  const size_t num_pages = 4 * pool_size;
+  const size_t ring_size = 4;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  NewNumberedPages(bpm, num_pages, &page_ids);
+  // The last pages created fill the pool.
+  std::vector<page_id_t> hot_page_ids(page_ids.end() - pool_size, page_ids.end());
+
+  BufferAccessStrategy strategy(ring_size);
+  std::vector<Page *> frames;
+  for (size_t i = 0; i < ring_size; i++) {
+    Page *page = bpm->FetchPageWithStrategy(page_ids[i], &strategy);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_ids[i], std::stoi(page->GetData()));
+    frames.push_back(page);
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  // The ring took ring_size pages of the hot set; the next misses go to the same frames, in the same order.
+  for (size_t i = ring_size; i < num_pages - pool_size; i++) {
+    Page *page = bpm->FetchPageWithStrategy(page_ids[i], &strategy);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_ids[i], std::stoi(page->GetData()));
+    EXPECT_EQ(frames[i % ring_size], page);
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+
+  // Only the pages the ring took their frames from have to be read again. Those are the least recently used ones, so
+  // go newest first, or reading them back would evict the rest in turn.
+  auto before = bpm->GetMetrics();
+  for (auto it = hot_page_ids.rbegin(); it != hot_page_ids.rend(); ++it) {
+    page_id_t page_id = *it;
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, std::stoi(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  auto after = bpm->GetMetrics();
+  EXPECT_GE(after.hits_ - before.hits_, pool_size - ring_size);
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// Scan a table much larger than the pool through a small ring. The scan must stay within its ring and leave the
+// pages that were resident before it in the pool.
+// NOLINTNEXTLINE
+TEST_F(BufferAccessStrategyTest, ParallelRingTest) {
+  const size_t num_instances = 2;
+  const size_t pool_size = 8;
+  const size_t num_frames = num_instances * pool_size;
+  const size_t num_pages = 4 * num_frames;
+  const size_t ring_size = 4;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  NewNumberedPages(bpm, num_pages, &page_ids);
+  // The hot set is the last pages created, half of each instance.
+  std::vector<page_id_t> hot_page_ids(page_ids.end() - num_frames / 2, page_ids.end());
+  for (page_id_t page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  BufferAccessStrategy strategy(ring_size);
+  std::vector<Page *> frames;
+  for (size_t i = 0; i + num_frames < num_pages; i++) {
+    auto guard = bpm->FetchPageRead(page_ids[i], &strategy);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_ids[i], std::stoi(guard.GetData()));
+    auto *frame = guard.AsPage<Page>();
+    if (std::find(frames.begin(), frames.end(), frame) == frames.end()) {
+      frames.push_back(frame);
+    }
+  }
+  EXPECT_EQ(ring_size, frames.size());
+
+  auto before = bpm->GetMetrics();
+  for (page_id_t page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  auto after = bpm->GetMetrics();
+  EXPECT_EQ(hot_page_ids.size(), after.hits_ - before.hits_);
+  EXPECT_EQ(0, after.misses_ - before.misses_);
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// A table scan with a ring, as the sequential scan executor runs it under BULK_READ, returns every tuple and keeps
+// the pages that were resident before it.
+// NOLINTNEXTLINE
+TEST_F(BufferAccessStrategyTest, TableScanTest) {
+  const size_t pool_size = 32;
+  const size_t num_tuples = 400;
+  const size_t ring_size = 4;
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  Schema schema({Column("id", TypeId::INTEGER), Column("payload", TypeId::VARCHAR, 1000)});
+  Transaction txn(0);
+  auto *table = new TableHeap(bpm, nullptr, nullptr, &txn);
+  const std::string payload(1000, 'x');
+  std::vector<RID> rids;
+  for (size_t i = 0; i < num_tuples; i++) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(static_cast<int32_t>(i)),
+                              ValueFactory::GetVarcharValue(payload)};
+    Tuple tuple(values, &schema);
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(tuple, &rid, &txn));
+    rids.push_back(rid);
+  }
+  ASSERT_GT(rids.back().GetPageId() - rids.front().GetPageId(), static_cast<page_id_t>(2 * pool_size));
+  // The table is several times the pool. Some other pages are in use next to it.
+  std::vector<page_id_t> hot_page_ids(pool_size / 2);
+  for (auto &page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  BufferAccessStrategy strategy(ring_size);
+  size_t num_scanned = 0;
+  for (auto it = table->Begin(&txn, &strategy); it != table->End(); ++it) {
+    EXPECT_EQ(static_cast<int32_t>(num_scanned), it->GetValue(&schema, 0).GetAs<int32_t>());
+    num_scanned++;
+  }
+  EXPECT_EQ(num_tuples, num_scanned);
+
+  // The scan missed on most of the table, but only into its ring.
+  auto before = bpm->GetMetrics();
+  for (page_id_t page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  auto after = bpm->GetMetrics();
+  EXPECT_EQ(hot_page_ids.size(), after.hits_ - before.hits_);
+
+  disk_manager->ShutDown();
+  delete table;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -11,15 +11,586 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <random>
+#include <set>
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
+#include "db_file_test_util.h"  // NOLINT
 #include "gtest/gtest.h"
+#include "storage/disk/simulated_disk_manager.h"
 
 namespace bustub {
 
 // NOLINTNEXTLINE
 // Check whether pages containing terminal characters can be recovered
 
+class BufferPoolInstanceTest : public DbFileTest {};
+
+// Point lookups from many threads on a working set that fits in the pool. Every FetchPage finds its page through the
+// striped page table, so there are no misses and nothing is evicted however many threads look pages up at once.
+// NOLINTNEXTLINE
+TEST_F(BufferPoolInstanceTest, ConcurrentHitTest) {
+  const size_t pool_size = 256;
+  const int num_lookups = 20000;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  NewNumberedPages(bpm, pool_size, &page_ids);
+
+  for (int num_threads = 1; num_threads <= 32; num_threads *= 4) {
+    auto before = bpm->GetMetrics();
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([bpm, &page_ids, tid]() {
+        std::mt19937 gen(tid);
+        std::uniform_int_distribution<size_t> dis(0, page_ids.size() - 1);
+        for (int i = 0; i < num_lookups; i++) {
+          page_id_t page_id = page_ids[dis(gen)];
+          auto *page = bpm->FetchPage(page_id);
+          ASSERT_NE(nullptr, page);
+          EXPECT_EQ(page_id, std::stoi(page->GetData()));
+          EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    auto after = bpm->GetMetrics();
+    EXPECT_EQ(static_cast<uint64_t>(num_threads * num_lookups), after.hits_ - before.hits_);
+    EXPECT_EQ(0, after.misses_ - before.misses_);
+    EXPECT_EQ(0, after.evictions_ - before.evictions_);
+  }
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// FlushPage writes a page only if it is dirty, or new and never written.
+// NOLINTNEXTLINE
+TEST_F(BufferPoolInstanceTest, FlushPageTest) {
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(10, disk_manager);
+
+  page_id_t page_id;
+  Page *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  snprintf(page->GetData(), PAGE_SIZE, "new");
+  EXPECT_TRUE(bpm->FlushPage(page_id));
+  EXPECT_EQ(1, disk_manager->GetNumWrites());
+  // Flushed and clean, so there is nothing to write.
+  EXPECT_TRUE(bpm->FlushPage(page_id));
+  EXPECT_EQ(1, disk_manager->GetNumWrites());
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  EXPECT_TRUE(bpm->FlushPage(page_id));
+  EXPECT_EQ(2, disk_manager->GetNumWrites());
+  EXPECT_TRUE(bpm->FlushPage(page_id));
+  EXPECT_EQ(2, disk_manager->GetNumWrites());
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// NewPage once the pool is full of unpinned pages, so every call has to evict. For pools 32 times apart in size, each
+// call takes exactly one victim from the replacer instead of scanning the frames, and the frame counts stay up to date.
+// Once every frame is pinned, NewPage fails on the counts alone, without looking for a victim.
+// NOLINTNEXTLINE
+TEST_F(BufferPoolInstanceTest, NewPageCostTest) {
+  const size_t num_new_pages = 2000;
+  const std::string db_name = "test.db";
+
+  for (size_t pool_size = 1024; pool_size <= 32768; pool_size *= 32) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+
+    page_id_t page_id;
+    for (size_t i = 0; i < pool_size; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    EXPECT_EQ(0, bpm->GetFreeFrameCount());
+    EXPECT_EQ(pool_size, bpm->GetEvictableFrameCount());
+
+    auto before = bpm->GetMetrics();
+    for (size_t i = 0; i < num_new_pages; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+      EXPECT_EQ(1, bpm->GetPinnedFrameCount());
+      EXPECT_EQ(pool_size - 1, bpm->GetEvictableFrameCount());
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+    auto after = bpm->GetMetrics();
+    EXPECT_EQ(num_new_pages, after.evictions_ - before.evictions_);
+    EXPECT_EQ(0, after.pin_failures_ - before.pin_failures_);
+    EXPECT_EQ(0, bpm->GetFreeFrameCount());
+    EXPECT_EQ(pool_size, bpm->GetEvictableFrameCount());
+
+    for (size_t i = 0; i < pool_size; i++) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    }
+    EXPECT_EQ(pool_size, bpm->GetPinnedFrameCount());
+    EXPECT_EQ(0, bpm->GetEvictableFrameCount());
+    before = bpm->GetMetrics();
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+    after = bpm->GetMetrics();
+    EXPECT_EQ(0, after.evictions_ - before.evictions_);
+    EXPECT_EQ(1, after.pin_failures_ - before.pin_failures_);
+
+    disk_manager->ShutDown();
+    delete bpm;
+    delete disk_manager;
+    RemoveDbFiles();
+  }
+}
+
+// Dirty every page in the pool, then let the page cleaner write them back. Misses that follow find clean victims,
+// so FetchPage does no write-backs of its own.
+// NOLINTNEXTLINE
+TEST_F(BufferPoolInstanceTest, PageCleanerTest) {
+  const size_t pool_size = 64;
+  const std::string db_name = "test.db";
+
+  // The cleaner asks the replacer for the next victims, so every policy has to name them.
+  for (ReplacerPolicy policy : {ReplacerPolicy::LRU, ReplacerPolicy::LRU_K, ReplacerPolicy::CLOCK}) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager, nullptr, policy);
+
+    std::vector<page_id_t> page_ids;
+    NewNumberedPages(bpm, 2 * pool_size, &page_ids);
+    EXPECT_EQ(pool_size, bpm->GetForegroundWritebackCount());
+
+    bpm->StartPageCleaner(1.0, 100000);
+    for (int i = 0; i < 500 && bpm->GetBackgroundWritebackCount() < pool_size; i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(pool_size, bpm->GetBackgroundWritebackCount());
+
+    // The first half of the pages was evicted, bring it back. The victims were all cleaned in the background.
+    for (size_t i = 0; i < pool_size; i++) {
+      auto *page = bpm->FetchPage(page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(page_ids[i], std::stoi(page->GetData()));
+      EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+    EXPECT_EQ(pool_size, bpm->GetForegroundWritebackCount());
+    bpm->StopPageCleaner();
+
+    // Pages written by the cleaner must read back with their contents.
+    for (size_t i = pool_size; i < 2 * pool_size; i++) {
+      auto *page = bpm->FetchPage(page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(page_ids[i], std::stoi(page->GetData()));
+      EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+
+    disk_manager->ShutDown();
+    RemoveDbFiles();
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+// Flush a pool of dirty pages while other threads keep fetching them. Every page must reach the disk once, with the
+// contents it had when the flush started.
+// NOLINTNEXTLINE
+TEST_F(BufferPoolInstanceTest, FlushAllTest) {
+  const size_t pool_size = 64;
+  const size_t num_readers = 2;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+
+  // Leave gaps in the page ids, so that the flush has several runs to write.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < pool_size; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, i % 5 != 4));
+    if (i % 5 != 4) {
+      page_ids.push_back(page_id);
+    }
+  }
+
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (size_t t = 0; t < num_readers; t++) {
+    readers.emplace_back([&] {
+      while (!done) {
+        for (page_id_t page_id : page_ids) {
+          auto guard = bpm->FetchPageRead(page_id);
+          EXPECT_EQ(page_id, std::stoi(guard.GetData()));
+        }
+      }
+    });
+  }
+  int num_writes = disk_manager->GetNumWrites();
+  bpm->FlushAllPages();
+  EXPECT_EQ(page_ids.size(), disk_manager->GetNumWrites() - num_writes);
+  // Nothing is dirty any more.
+  bpm->FlushAllPages();
+  EXPECT_EQ(page_ids.size(), disk_manager->GetNumWrites() - num_writes);
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  char data[PAGE_SIZE];
+  for (page_id_t page_id : page_ids) {
+    disk_manager->ReadPage(page_id, data);
+    EXPECT_EQ(page_id, std::stoi(data));
+  }
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// Fetch the pages of sorted RID lists, as an index scan would, from a table much larger than the pool. One FetchPages
+// per list reads the missing pages in runs of consecutive ones, so it takes fewer reads than a FetchPage per RID.
+// NOLINTNEXTLINE
+TEST_F(BufferPoolInstanceTest, RidListFetchTest) {
+  const size_t pool_size = 256;
+  const size_t num_pages = 16 * pool_size;
+  const size_t list_span = 256;
+  const int num_lists = 200;
+  const std::string db_name = "test.db";
+
+  SimulatedDiskConfig config;
+  config.read_latency_ = config.write_latency_ = std::chrono::nanoseconds(0);
+  auto *disk_manager = new SimulatedDiskManager(db_name, config);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  NewNumberedPages(bpm, num_pages, &page_ids);
+  bpm->FlushAllPages();
+  delete bpm;
+
+  // Each list holds about half of the pages of a random stretch of the table, sometimes twice.
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<page_id_t> start_dis(0, num_pages - list_span);
+  std::uniform_int_distribution<int> pick_dis(0, 3);
+  std::vector<std::vector<page_id_t>> rid_lists(num_lists);
+  for (auto &rid_list : rid_lists) {
+    page_id_t start = start_dis(gen);
+    for (page_id_t page_id = start; page_id < start + static_cast<page_id_t>(list_span); page_id++) {
+      int pick = pick_dis(gen);
+      for (int i = 0; i < pick - 1; i++) {
+        rid_list.push_back(page_id);
+      }
+    }
+  }
+
+  // Both start from a cold pool.
+  uint64_t reads[2];
+  for (bool batched : {false, true}) {
+    bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+    disk_manager->ResetIoCounters();
+    std::vector<Page *> pages;
+    for (const auto &rid_list : rid_lists) {
+      pages.resize(rid_list.size());
+      if (batched) {
+        bpm->FetchPages(rid_list.data(), rid_list.size(), pages.data());
+      } else {
+        for (size_t i = 0; i < rid_list.size(); i++) {
+          pages[i] = bpm->FetchPage(rid_list[i]);
+        }
+      }
+      for (size_t i = 0; i < rid_list.size(); i++) {
+        ASSERT_NE(nullptr, pages[i]);
+        EXPECT_EQ(rid_list[i], std::stoi(pages[i]->GetData()));
+        EXPECT_TRUE(bpm->UnpinPage(rid_list[i], false));
+      }
+    }
+    reads[static_cast<int>(batched)] = disk_manager->GetIoCounters().reads_;
+    delete bpm;
+  }
+  // The runs are two pages long on average.
+  EXPECT_LT(3 * reads[1], 2 * reads[0]);
+
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+// Deleted pages are handed out again before the file grows, each by the instance it belongs to.
+// NOLINTNEXTLINE
+TEST_F(BufferPoolInstanceTest, PageReuseTest) {
+  const size_t num_instances = 2;
+  const size_t pool_size = 8;
+  const size_t num_pages = pool_size * 2;
+  const std::string db_name = "test.db";
+
+  // Two instances of a parallel pool, which share the free page map of the disk manager.
+  auto *disk_manager = new DiskManager(db_name);
+  std::vector<BufferPoolManagerInstance *> instances;
+  std::vector<std::vector<page_id_t>> page_ids(num_instances);
+  for (size_t i = 0; i < num_instances; i++) {
+    instances.push_back(new BufferPoolManagerInstance(pool_size, num_instances, i, disk_manager));
+    for (size_t j = 0; j < num_pages; j++) {
+      page_id_t page_id;
+      Page *page = instances[i]->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+      EXPECT_TRUE(instances[i]->UnpinPage(page_id, true));
+      page_ids[i].push_back(page_id);
+    }
+  }
+
+  // Delete every other page of the first instance, resident or not. The other instance does not take them.
+  std::set<page_id_t> deleted;
+  for (size_t j = 0; j < num_pages; j += 2) {
+    EXPECT_TRUE(instances[0]->DeletePage(page_ids[0][j]));
+    deleted.insert(page_ids[0][j]);
+  }
+  EXPECT_EQ(deleted.size(), disk_manager->GetNumFreePages());
+  page_id_t page_id;
+  ASSERT_NE(nullptr, instances[1]->NewPage(&page_id));
+  EXPECT_EQ(page_ids[1].back() + num_instances, page_id);
+  EXPECT_TRUE(instances[1]->UnpinPage(page_id, false));
+
+  // The first instance takes its deleted pages back, lowest id first, before it allocates new ones.
+  for (page_id_t deleted_page_id : deleted) {
+    Page *page = instances[0]->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(deleted_page_id, page_id);
+    EXPECT_EQ(0, page->GetData()[0]);
+    EXPECT_TRUE(instances[0]->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, disk_manager->GetNumFreePages());
+  ASSERT_NE(nullptr, instances[0]->NewPage(&page_id));
+  EXPECT_EQ(page_ids[0].back() + num_instances, page_id);
+  EXPECT_TRUE(instances[0]->UnpinPage(page_id, false));
+
+  // The pages that were kept are untouched.
+  for (size_t j = 1; j < num_pages; j += 2) {
+    Page *page = instances[0]->FetchPage(page_ids[0][j]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_ids[0][j], std::stoi(page->GetData()));
+    EXPECT_TRUE(instances[0]->UnpinPage(page_ids[0][j], false));
+  }
+
+  disk_manager->ShutDown();
+  for (auto *instance : instances) {
+    delete instance;
+  }
+  delete disk_manager;
+}
+
+// Page ids past the main segment belong to the segment files, so NewPage fails once the main segment is used up,
+// rather than create a page in a segment.
+// NOLINTNEXTLINE
+TEST_F(BufferPoolInstanceTest, MainSegmentFullTest) {
+  const size_t pool_size = 4;
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+
+  // Leave two ids of the main segment, past one extent with all the others.
+  const auto max_pages = static_cast<page_id_t>(DiskManager::SEGMENT_MAX_PAGES);
+  ASSERT_EQ(0, disk_manager->AllocateExtent(DiskManager::SEGMENT_MAX_PAGES - 2));
+  page_id_t page_ids[2];
+  for (auto &page_id : page_ids) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_EQ(DiskManager::MAIN_SEGMENT, DiskManager::GetSegmentId(page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ(max_pages - 1, page_ids[1]);
+  page_id_t page_id = INVALID_PAGE_ID;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+  // A deleted page makes room again.
+  EXPECT_TRUE(bpm->DeletePage(page_ids[0]));
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(page_ids[0], page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(BufferPoolInstanceTest, MmapReadOnlyTest) {
+  const size_t pool_size = 4;
+  const size_t num_pages = 16;
+  const std::string db_name = "test.db";
+  {
+    DiskManager disk_manager(db_name);
+    char data[PAGE_SIZE];
+    for (size_t i = 0; i < num_pages; i++) {
+      snprintf(data, PAGE_SIZE, "%zu", i);
+      disk_manager.WritePage(i, data);
+    }
+    disk_manager.ShutDown();
+  }
+
+  auto *disk_manager = new DiskManager(db_name, AsyncIoType::AUTO, DurabilityMode::NONE, DiskIoMode::MMAP_READ_ONLY);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  // Misses are served from the mapping, without a copy, to readers.
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(num_pages); page_id++) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(disk_manager->GetMappedPage(page_id), std::as_const(*page).GetData());
+    EXPECT_EQ(page_id, std::stoi(std::as_const(*page).GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(num_pages, bpm->GetMetrics().mapped_reads_);
+
+  // Write-latching a page copies it into its frame, which leaves the mapping alone.
+  Page *page = bpm->FetchPage(1);
+  ASSERT_NE(nullptr, page);
+  page->WLatch();
+  EXPECT_NE(disk_manager->GetMappedPage(1), page->GetData());
+  EXPECT_EQ(1, std::stoi(page->GetData()));
+  snprintf(page->GetData(), PAGE_SIZE, "changed");
+  page->WUnlatch();
+  EXPECT_EQ(1, std::stoi(disk_manager->GetMappedPage(1)));
+  EXPECT_TRUE(bpm->UnpinPage(1, true));
+
+  // So does writing without the latch. The mapping is read-only; a write into it would fault.
+  page = bpm->FetchPage(2);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(disk_manager->GetMappedPage(2), std::as_const(*page).GetData());
+  snprintf(page->GetData(), PAGE_SIZE, "changed");
+  EXPECT_STREQ("changed", std::as_const(*page).GetData());
+  EXPECT_EQ(2, std::stoi(disk_manager->GetMappedPage(2)));
+  EXPECT_TRUE(bpm->UnpinPage(2, true));
+
+  // Pages past the end of the mapping are read into the frame's own memory, also in frames that pointed into it.
+  for (size_t i = 0; i < pool_size; i++) {
+    const page_id_t page_id = num_pages + i;
+    page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, page->GetData()[0]);
+    snprintf(page->GetData(), PAGE_SIZE, "past the end");
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(BufferPoolInstanceTest, DirectIoTest) {
+  const size_t pool_size = 4;
+  const size_t num_pages = 32;
+  const std::string db_name = "test.db";
+  auto *disk_manager = new DiskManager(db_name, AsyncIoType::AUTO, DurabilityMode::NONE, DiskIoMode::DIRECT);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  bpm->StartPageCleaner(0.5, 1000);
+
+  // Evictions, the page cleaner and FlushAllPages write frames or aligned copies of them, without bouncing.
+  std::vector<page_id_t> page_ids;
+  NewNumberedPages(bpm, num_pages, &page_ids);
+  bpm->FlushAllPages();
+  bpm->StopPageCleaner();
+  for (page_id_t page_id : page_ids) {
+    Page *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, std::stoi(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// Grow a pool into its spare frames and shrink it back while a page is pinned, then resize it while other threads
+// read pages. Every page must keep its contents through the evictions.
+// NOLINTNEXTLINE
+TEST_F(BufferPoolInstanceTest, ResizeTest) {
+  const size_t pool_size = 8;
+  const size_t max_pool_size = 16;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager, nullptr, ReplacerPolicy::LRU,
+                                            HugePageMode::NONE, false, max_pool_size);
+  EXPECT_FALSE(bpm->Resize(0));
+  EXPECT_FALSE(bpm->Resize(max_pool_size + 1));
+
+  std::vector<page_id_t> page_ids;
+  auto new_pages = [&](size_t num_pages) {
+    for (size_t i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+      page_ids.push_back(page_id);
+    }
+  };
+  new_pages(pool_size);
+  ASSERT_TRUE(bpm->Resize(max_pool_size));
+  EXPECT_EQ(max_pool_size, bpm->GetPoolSize());
+  new_pages(max_pool_size - pool_size);
+  EXPECT_EQ(0, bpm->GetMetrics().evictions_);
+
+  // The last page sits in the last frame. Shrinking has to wait until it is unpinned.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids.back()));
+  std::atomic<bool> resized{false};
+  std::thread resizer([&]() {
+    EXPECT_TRUE(bpm->Resize(pool_size / 2));
+    resized = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(resized);
+  EXPECT_TRUE(bpm->UnpinPage(page_ids.back(), false));
+  resizer.join();
+  EXPECT_EQ(pool_size / 2, bpm->GetPoolSize());
+  EXPECT_EQ(pool_size / 2, bpm->GetFreeFrameCount() + bpm->GetEvictableFrameCount());
+
+  for (page_id_t page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, std::stoi(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  // Resize back and forth under concurrent readers.
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int tid = 0; tid < 4; tid++) {
+    readers.emplace_back([&, tid]() {
+      std::mt19937 gen(tid);
+      std::uniform_int_distribution<size_t> dis(0, page_ids.size() - 1);
+      while (!done) {
+        page_id_t page_id = page_ids[dis(gen)];
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;  // all frames are pinned by the other readers for a moment
+        }
+        EXPECT_EQ(page_id, std::stoi(page->GetData()));
+        EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+      }
+    });
+  }
+  for (size_t i = 0; i < 20; i++) {
+    EXPECT_TRUE(bpm->Resize(i % 2 == 0 ? max_pool_size : pool_size));
+  }
+  done = true;
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(pool_size, bpm->GetPoolSize());
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
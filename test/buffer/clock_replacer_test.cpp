@@ -11,15 +11,19 @@
 //===----------------------------------------------------------------------===//
 
 #include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
 #include <thread>  // NOLINT
 #include <vector>
 
 #include "buffer/clock_replacer.h"
+#include "buffer/lru_replacer.h"
 #include "gtest/gtest.h"
 
 namespace bustub {
 
-TEST(ClockReplacerTest, DISABLED_SampleTest) {
+TEST(ClockReplacerTest, SampleTest) {
   ClockReplacer clock_replacer(7);
 
   // Scenario: unpin six elements, i.e. add them to the replacer.
@@ -59,4 +63,139 @@ TEST(ClockReplacerTest, DISABLED_SampleTest) {
   EXPECT_EQ(4, value);
 }
 
+// PeekVictims names the frames in the order Victim takes them, without moving the hand or clearing reference bits.
+// NOLINTNEXTLINE
+TEST(ClockReplacerTest, PeekVictimsTest) {
+  ClockReplacer clock_replacer(4);
+  for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) {
+    clock_replacer.Unpin(frame_id);
+  }
+  frame_id_t victim;
+  ASSERT_TRUE(clock_replacer.Victim(&victim));
+  EXPECT_EQ(0, victim);
+  // The sweep cleared the reference bits of 1 to 3. Referencing 2 again moves it behind the others.
+  clock_replacer.Pin(2);
+  clock_replacer.Unpin(2);
+
+  std::vector<frame_id_t> frame_ids;
+  clock_replacer.PeekVictims(&frame_ids, 4);
+  EXPECT_EQ((std::vector<frame_id_t>{1, 3, 2}), frame_ids);
+  frame_ids.clear();
+  clock_replacer.PeekVictims(&frame_ids, 2);
+  EXPECT_EQ((std::vector<frame_id_t>{1, 3}), frame_ids);
+  for (frame_id_t expected : {1, 3, 2}) {
+    ASSERT_TRUE(clock_replacer.Victim(&victim));
+    EXPECT_EQ(expected, victim);
+  }
+}
+
+// Threads pin and unpin frames concurrently while another thread keeps victimizing. Every frame must come out of
+// Victim at most once per Unpin, and the replacer must end up empty.
+// NOLINTNEXTLINE
+TEST(ClockReplacerTest, ConcurrencyTest) {
+  const int num_threads = 8;
+  const int frames_per_thread = 64;
+  const int num_rounds = 2000;
+  ClockReplacer clock_replacer(num_threads * frames_per_thread);
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&clock_replacer, tid]() {
+      for (int round = 0; round < num_rounds; round++) {
+        frame_id_t frame_id = tid * frames_per_thread + round % frames_per_thread;
+        clock_replacer.Unpin(frame_id);
+        clock_replacer.Pin(frame_id);
+        clock_replacer.Unpin(frame_id);
+      }
+    });
+  }
+  threads.emplace_back([&clock_replacer]() {
+    frame_id_t frame_id;
+    for (int i = 0; i < num_rounds; i++) {
+      clock_replacer.Victim(&frame_id);
+    }
+  });
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  std::vector<bool> seen(num_threads * frames_per_thread, false);
+  frame_id_t frame_id;
+  size_t size = clock_replacer.Size();
+  for (size_t i = 0; i < size; i++) {
+    ASSERT_TRUE(clock_replacer.Victim(&frame_id));
+    EXPECT_FALSE(seen[frame_id]);
+    seen[frame_id] = true;
+  }
+  EXPECT_EQ(0, clock_replacer.Size());
+  EXPECT_FALSE(clock_replacer.Victim(&frame_id));
+}
+
+// Pin/Unpin of ClockReplacer and LRUReplacer from many threads. Each thread pins and unpins random frames of its own,
+// like hits on different pages, while one thread in eight also victimizes. Every frame ends unpinned, so it is either
+// still in the replacer, once, or was taken as a victim after its last Unpin.
+// NOLINTNEXTLINE
+TEST(ClockReplacerTest, ConcurrentPinUnpinTest) {
+  const size_t frames_per_thread = 1024;
+  const int num_ops = 20000;
+
+  for (int num_threads = 1; num_threads <= 64; num_threads *= 8) {
+    for (const std::string policy : {"clock", "lru"}) {
+      size_t num_pages = num_threads * frames_per_thread;
+      std::unique_ptr<Replacer> replacer;
+      if (policy == "clock") {
+        replacer = std::make_unique<ClockReplacer>(num_pages);
+      } else {
+        replacer = std::make_unique<LRUReplacer>(num_pages);
+      }
+      std::vector<std::vector<bool>> touched(num_threads, std::vector<bool>(frames_per_thread));
+      std::vector<std::vector<frame_id_t>> victims(num_threads);
+      std::vector<std::thread> threads;
+      for (int tid = 0; tid < num_threads; tid++) {
+        threads.emplace_back([&replacer, &touched, &victims, tid, frames_per_thread]() {
+          std::mt19937 gen(tid);
+          std::uniform_int_distribution<size_t> dis(0, frames_per_thread - 1);
+          frame_id_t victim;
+          for (int i = 0; i < num_ops; i++) {
+            size_t frame_no = dis(gen);
+            auto frame_id = static_cast<frame_id_t>(tid * frames_per_thread + frame_no);
+            replacer->Pin(frame_id);
+            replacer->Unpin(frame_id);
+            touched[tid][frame_no] = true;
+            if (tid % 8 == 0 && i % 64 == 0 && replacer->Victim(&victim)) {
+              victims[tid].push_back(victim);
+            }
+          }
+        });
+      }
+      for (auto &thread : threads) {
+        thread.join();
+      }
+
+      std::vector<bool> victimized(num_pages);
+      for (const auto &thread_victims : victims) {
+        for (frame_id_t frame_id : thread_victims) {
+          victimized[frame_id] = true;
+        }
+      }
+      const size_t size = replacer->Size();
+      std::vector<bool> left(num_pages);
+      frame_id_t frame_id;
+      for (size_t i = 0; i < size; i++) {
+        ASSERT_TRUE(replacer->Victim(&frame_id));
+        EXPECT_FALSE(left[frame_id]);
+        left[frame_id] = true;
+      }
+      EXPECT_FALSE(replacer->Victim(&frame_id));
+      for (size_t i = 0; i < num_pages; i++) {
+        if (touched[i / frames_per_thread][i % frames_per_thread]) {
+          EXPECT_TRUE(left[i] || victimized[i]) << policy << ", frame " << i;
+        } else {
+          EXPECT_FALSE(left[i]) << policy << ", frame " << i;
+        }
+      }
+    }
+  }
+}
+
 }  // namespace bustub
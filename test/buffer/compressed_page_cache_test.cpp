@@ -0,0 +1,194 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache_test.cpp
+//
+// Identification: test/buffer/compressed_page_cache_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/compressed_page_cache.h"
+#include "db_file_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+class CompressedPageCacheTest : public DbFileTest {};
+
+// NOLINTNEXTLINE
+TEST_F(CompressedPageCacheTest, SampleTest) {
+  char page[PAGE_SIZE] = {0};
+  char out[PAGE_SIZE];
+  CompressedPageCache cache(PAGE_SIZE);
+
+  snprintf(page, PAGE_SIZE, "page 1");
+  cache.Insert(1, page);
+  snprintf(page, PAGE_SIZE, "page 2");
+  cache.Insert(2, page);
+  EXPECT_EQ(2, cache.GetNumPages());
+  EXPECT_LT(cache.GetSize(), PAGE_SIZE / 8);
+
+  // Inserting a page again replaces it.
+  snprintf(page, PAGE_SIZE, "page 2, again");
+  cache.Insert(2, page);
+  EXPECT_EQ(2, cache.GetNumPages());
+
+  // Get hands the page back and forgets it.
+  ASSERT_TRUE(cache.Get(2, out));
+  EXPECT_STREQ("page 2, again", out);
+  EXPECT_FALSE(cache.Get(2, out));
+  cache.Erase(1);
+  EXPECT_FALSE(cache.Get(1, out));
+  EXPECT_EQ(0, cache.GetNumPages());
+  EXPECT_EQ(0, cache.GetSize());
+
+  // Random data is not worth keeping, and drops the older copy.
+  cache.Insert(1, page);
+  std::mt19937 gen(0);
+  for (auto &byte : page) {
+    byte = static_cast<char>(gen());
+  }
+  cache.Insert(1, page);
+  EXPECT_FALSE(cache.Get(1, out));
+}
+
+// NOLINTNEXTLINE
+TEST_F(CompressedPageCacheTest, CapacityTest) {
+  const size_t num_pages = 64;
+  char page[PAGE_SIZE] = {0};
+  char out[PAGE_SIZE];
+  CompressedPageCache cache(PAGE_SIZE);
+
+  // Make every page cost a few hundred bytes, so that only some of them fit.
+  std::mt19937 gen(0);
+  for (size_t i = 0; i < 256; i++) {
+    page[i] = static_cast<char>(gen());
+  }
+  for (size_t i = 0; i < num_pages; i++) {
+    memcpy(page + 256, &i, sizeof(i));
+    cache.Insert(static_cast<page_id_t>(i), page);
+    EXPECT_LE(cache.GetSize(), cache.GetCapacity());
+  }
+  size_t num_cached = cache.GetNumPages();
+  EXPECT_GT(num_cached, 0);
+  EXPECT_LT(num_cached, num_pages);
+
+  // The oldest pages were dropped.
+  EXPECT_FALSE(cache.Get(0, out));
+  for (size_t i = num_pages - num_cached; i < num_pages; i++) {
+    ASSERT_TRUE(cache.Get(static_cast<page_id_t>(i), out));
+    size_t value;
+    memcpy(&value, out + 256, sizeof(value));
+    EXPECT_EQ(i, value);
+  }
+}
+
+// A pool with a compressed cache reads evicted pages back from it, and never hands out a stale copy.
+// NOLINTNEXTLINE
+TEST_F(CompressedPageCacheTest, BufferPoolTest) {
+  const size_t pool_size = 8;
+  const size_t num_pages = 8 * pool_size;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager, nullptr, ReplacerPolicy::LRU,
+                                            HugePageMode::NONE, false, 0, num_pages * PAGE_SIZE / 4);
+
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // Every evicted page was written back, then cached, so none of these misses reads the disk.
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(num_pages - pool_size); page_id++) {
+    auto guard = bpm->FetchPageWrite(page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_id, std::stoi(guard.GetData()));
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "%d", -page_id);
+  }
+  auto metrics = bpm->GetMetrics();
+  EXPECT_EQ(num_pages - pool_size, metrics.compressed_cache_hits_);
+
+  // The second round sees the modifications, whether from the cache or from the disk.
+  std::vector<page_id_t> page_ids(num_pages - pool_size);
+  std::iota(page_ids.begin(), page_ids.end(), 0);
+  for (page_id_t page_id : page_ids) {
+    auto guard = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(-page_id, std::stoi(guard.GetData()));
+  }
+  EXPECT_EQ(2 * (num_pages - pool_size), bpm->GetMetrics().compressed_cache_hits_);
+
+  // Deleting a page drops it from the cache too.
+  ASSERT_TRUE(bpm->DeletePage(page_ids[0]));
+  bpm->FetchPageRead(page_ids[0]).Drop();
+  EXPECT_EQ(2 * (num_pages - pool_size), bpm->GetMetrics().compressed_cache_hits_);
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// Threads increment counters on random pages of a pool much smaller than the table. Any stale copy handed out by the
+// cache would lose increments.
+// NOLINTNEXTLINE
+TEST_F(CompressedPageCacheTest, ConcurrencyTest) {
+  const size_t pool_size = 8;
+  const size_t num_pages = 64;
+  const int num_threads = 4;
+  const int num_increments = 2000;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager, nullptr, ReplacerPolicy::LRU,
+                                            HugePageMode::NONE, false, 0, num_pages * PAGE_SIZE / 8);
+  bpm->StartPageCleaner(0.5, 1000);
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([bpm, tid] {
+      std::mt19937 gen(tid);
+      std::uniform_int_distribution<page_id_t> dis(0, num_pages - 1);
+      for (int i = 0; i < num_increments; i++) {
+        auto guard = bpm->FetchPageWrite(dis(gen));
+        ASSERT_TRUE(guard.IsValid());
+        (*guard.AsMut<int>())++;
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  bpm->StopPageCleaner();
+
+  int total = 0;
+  for (page_id_t page_id = 0; page_id < static_cast<page_id_t>(num_pages); page_id++) {
+    total += *bpm->FetchPageRead(page_id).As<int>();
+  }
+  EXPECT_EQ(num_threads * num_increments, total);
+  EXPECT_GT(bpm->GetMetrics().compressed_cache_hits_, 0);
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
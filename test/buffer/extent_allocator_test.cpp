@@ -0,0 +1,142 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extent_allocator_test.cpp
+//
+// Identification: test/buffer/extent_allocator_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "buffer/extent_allocator.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "db_file_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+class ExtentAllocatorTest : public DbFileTest {};
+
+// NOLINTNEXTLINE
+TEST_F(ExtentAllocatorTest, ExtentTest) {
+  const size_t num_instances = 4;
+  const size_t pool_size = 16;
+  const size_t num_pages = 20;
+  const size_t extent_size = 16;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+  // Two objects that grow at the same time, and pages that belong to no extent in between.
+  ExtentAllocator extents[2]{ExtentAllocator(extent_size), ExtentAllocator(extent_size)};
+  std::vector<page_id_t> page_ids[2];
+  std::set<page_id_t> all_page_ids;
+  for (size_t i = 0; i < num_pages; i++) {
+    for (size_t j = 0; j < 2; j++) {
+      page_id_t page_id;
+      Page *page = bpm->NewPageInExtent(&page_id, &extents[j]);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+      page_ids[j].push_back(page_id);
+      EXPECT_TRUE(all_page_ids.insert(page_id).second);
+    }
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    EXPECT_TRUE(all_page_ids.insert(page_id).second);
+  }
+
+  // Each object's pages come in runs of consecutive ids, one per extent, even though the objects grew interleaved.
+  for (size_t j = 0; j < 2; j++) {
+    EXPECT_EQ(2, extents[j].GetNumExtents());
+    for (size_t i = 0; i < num_pages; i++) {
+      if (i % extent_size == 0) {
+        EXPECT_EQ(0, page_ids[j][i] % extent_size);
+      } else {
+        EXPECT_EQ(page_ids[j][i - 1] + 1, page_ids[j][i]);
+      }
+    }
+  }
+
+  // Every page went to the instance its id belongs to, so it is found again after being evicted.
+  bpm->FlushAllPages();
+  for (auto &ids : page_ids) {
+    for (page_id_t page_id : ids) {
+      Page *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(page_id, std::stoi(page->GetData()));
+      EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+    }
+  }
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(ExtentAllocatorTest, SegmentTest) {
+  const size_t num_instances = 2;
+  const size_t pool_size = 4;
+  const size_t num_pages = 32;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+  const segment_id_t segment_id = disk_manager->CreateSegment();
+  ExtentAllocator extent(ExtentAllocator::DEFAULT_EXTENT_SIZE, segment_id);
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; i++) {
+    page_id_t page_id;
+    Page *page = bpm->NewPageInExtent(&page_id, &extent);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(segment_id, DiskManager::GetSegmentId(page_id));
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  // Most pages were evicted, and written to the segment file.
+  EXPECT_LT(0, disk_manager->GetSegmentFileSize(segment_id));
+  EXPECT_EQ(0, disk_manager->GetDbFileSize());
+
+  // A pinned page stays, the others go without being written back.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids.back()));
+  EXPECT_FALSE(bpm->DiscardSegment(segment_id));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids.back(), true));
+  EXPECT_TRUE(bpm->DiscardSegment(segment_id));
+  disk_manager->TruncateSegment(segment_id);
+  bpm->FlushAllPages();
+  EXPECT_EQ(0, disk_manager->GetSegmentFileSize(segment_id));
+
+  // The segment starts over.
+  extent.Reset();
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPageInExtent(&page_id, &extent));
+  EXPECT_EQ(DiskManager::GetFirstPageId(segment_id), page_id);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  Page *page = bpm->FetchPage(page_ids[1]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, page->GetData()[0]);
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[1], false));
+
+  // Dropping it gives the file back.
+  EXPECT_TRUE(bpm->DiscardSegment(segment_id));
+  disk_manager->DropSegment(segment_id);
+  bpm->FlushAllPages();
+  EXPECT_EQ(0, disk_manager->GetSegmentFileSize(segment_id));
+  EXPECT_EQ(0, disk_manager->GetDbFileSize());
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
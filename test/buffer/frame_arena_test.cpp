@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena_test.cpp
+//
+// Identification: test/buffer/frame_arena_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/frame_arena.h"
+#include "db_file_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+class FrameArenaTest : public DbFileTest {};
+
+// Frames are PAGE_SIZE-aligned, zeroed and do not overlap, in every huge page mode.
+// NOLINTNEXTLINE
+TEST_F(FrameArenaTest, AlignmentTest) {
+  const size_t num_frames = 1000;
+  for (auto mode : {HugePageMode::NONE, HugePageMode::TRANSPARENT, HugePageMode::EXPLICIT}) {
+    for (bool prefault : {false, true}) {
+      FrameArena arena(num_frames, mode, prefault);
+      if (mode == HugePageMode::TRANSPARENT || (mode == HugePageMode::EXPLICIT && !arena.UsesExplicitHugePages())) {
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(arena.GetFrameData(0)) % FrameArena::HUGE_PAGE_SIZE);
+      }
+      for (size_t i = 0; i < num_frames; i++) {
+        char *data = arena.GetFrameData(i);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(data) % PAGE_SIZE);
+        EXPECT_EQ(0, data[0]);
+        EXPECT_EQ(0, data[PAGE_SIZE - 1]);
+        memset(data, static_cast<int>(i % 128), PAGE_SIZE);
+      }
+      for (size_t i = 0; i < num_frames; i++) {
+        EXPECT_EQ(static_cast<char>(i % 128), arena.GetFrameData(i)[PAGE_SIZE - 1]);
+      }
+    }
+  }
+}
+
+// A buffer pool on a huge page arena behaves like any other.
+// NOLINTNEXTLINE
+TEST_F(FrameArenaTest, BufferPoolTest) {
+  const size_t pool_size = 16;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager, nullptr, ReplacerPolicy::LRU,
+                                            HugePageMode::TRANSPARENT, true);
+  page_id_t page_id;
+  for (size_t i = 0; i < 2 * pool_size; i++) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % PAGE_SIZE);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  for (page_id_t i = 0; i < static_cast<page_id_t>(2 * pool_size); i++) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(i, std::stoi(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
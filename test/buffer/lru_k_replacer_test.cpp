@@ -0,0 +1,134 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lru_k_replacer_test.cpp
+//
+// Identification: test/buffer/lru_k_replacer_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/lru_k_replacer.h"
+#include "db_file_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+class LRUKReplacerTest : public DbFileTest {};
+
+// NOLINTNEXTLINE
+TEST_F(LRUKReplacerTest, SampleTest) {
+  LRUKReplacer lru_k_replacer(7, 2);
+
+  // Frames 1-5 are accessed once, frame 1 a second time at the end. Frame 6 is never accessed.
+  for (frame_id_t frame_id = 1; frame_id <= 5; frame_id++) {
+    lru_k_replacer.RecordAccess(frame_id);
+  }
+  lru_k_replacer.RecordAccess(1);
+  for (frame_id_t frame_id = 1; frame_id <= 6; frame_id++) {
+    lru_k_replacer.Unpin(frame_id);
+  }
+  EXPECT_EQ(6, lru_k_replacer.Size());
+
+  // Frames with fewer than two accesses go first, oldest access first, then the frame that was unpinned without
+  // being accessed. Frame 1 has a finite backward 2-distance and goes last.
+  std::vector<frame_id_t> expected{2, 3, 4, 5, 6, 1};
+  std::vector<frame_id_t> peeked;
+  lru_k_replacer.PeekVictims(&peeked, 10);
+  EXPECT_EQ(expected, peeked);
+
+  frame_id_t value;
+  for (frame_id_t frame_id : expected) {
+    ASSERT_TRUE(lru_k_replacer.Victim(&value));
+    EXPECT_EQ(frame_id, value);
+  }
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(0, lru_k_replacer.Size());
+}
+
+// NOLINTNEXTLINE
+TEST_F(LRUKReplacerTest, KDistanceTest) {
+  LRUKReplacer lru_k_replacer(4, 2);
+
+  // Access order 0 1 2 0 1 2 1: the second most recent accesses are 0 -> 4, 1 -> 5, 2 -> 6.
+  for (frame_id_t frame_id : {0, 1, 2, 0, 1, 2, 1}) {
+    lru_k_replacer.RecordAccess(frame_id);
+  }
+  for (frame_id_t frame_id = 0; frame_id < 3; frame_id++) {
+    lru_k_replacer.Unpin(frame_id);
+  }
+
+  // Pinned frames are not victimized, and an access to an unpinned frame moves it.
+  lru_k_replacer.Pin(0);
+  lru_k_replacer.RecordAccess(1);
+  frame_id_t value;
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(1, value);
+  EXPECT_FALSE(lru_k_replacer.Victim(&value));
+
+  // Back-to-back accesses count once, so frame 3 still has an infinite backward distance.
+  lru_k_replacer.RecordAccess(3);
+  lru_k_replacer.RecordAccess(3);
+  lru_k_replacer.RecordAccess(3);
+  lru_k_replacer.Unpin(0);
+  lru_k_replacer.Unpin(3);
+  ASSERT_TRUE(lru_k_replacer.Victim(&value));
+  EXPECT_EQ(3, value);
+
+  // Removing a frame drops its history.
+  lru_k_replacer.Remove(0);
+  EXPECT_EQ(0, lru_k_replacer.Size());
+  lru_k_replacer.RecordAccess(0);
+  lru_k_replacer.Unpin(0);
+  std::vector<frame_id_t> peeked;
+  lru_k_replacer.PeekVictims(&peeked, 1);
+  ASSERT_EQ(1, peeked.size());
+  EXPECT_EQ(0, peeked[0]);
+}
+
+// A scan over more pages than the pool holds must not evict pages that are used over and over.
+// NOLINTNEXTLINE
+TEST_F(LRUKReplacerTest, ScanResistanceTest) {
+  const size_t pool_size = 10;
+  const size_t num_hot_pages = 5;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager, nullptr, ReplacerPolicy::LRU_K);
+
+  // The hot pages are dirty, so evicting any of them shows up as a foreground write-back.
+  std::vector<page_id_t> hot_page_ids;
+  page_id_t page_id;
+  for (size_t i = 0; i < num_hot_pages; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    hot_page_ids.push_back(page_id);
+  }
+  // Touch the hot pages once more, interleaved so that the accesses are not correlated.
+  for (page_id_t hot_page_id : hot_page_ids) {
+    ASSERT_NE(nullptr, bpm->FetchPage(hot_page_id));
+    EXPECT_TRUE(bpm->UnpinPage(hot_page_id, false));
+  }
+
+  // Scan pages are each touched once, so they replace each other and leave the hot pages alone.
+  for (size_t i = 0; i < 10 * pool_size; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(0, bpm->GetForegroundWritebackCount());
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
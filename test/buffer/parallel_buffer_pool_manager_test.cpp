@@ -11,10 +11,16 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/parallel_buffer_pool_manager.h"
+#include <algorithm>
 #include <cstdio>
+#include <numeric>
 #include <random>
+#include <set>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 #include "buffer/buffer_pool_manager.h"
+#include "db_file_test_util.h"  // NOLINT
 #include "gtest/gtest.h"
 
 namespace bustub {
@@ -23,5 +29,252 @@ namespace bustub {
 // NOLINTNEXTLINE
 // Check whether pages containing terminal characters can be recovered
 
+class ParallelBufferPoolTest : public DbFileTest {};
+
+// Concurrent NewPage on a parallel pool of fixed total size, for increasing instance counts. The instances hand out
+// pages without a latch over all of them: every page id must be handed out once, and the pages must be spread over
+// all instances.
+// NOLINTNEXTLINE
+TEST_F(ParallelBufferPoolTest, ParallelNewPageTest) {
+  const size_t total_pool_size = 4096;
+  const int num_threads = 16;
+  const int num_new_pages = 5000;
+  const std::string db_name = "test.db";
+
+  for (size_t num_instances = 1; num_instances <= 16; num_instances *= 2) {
+    auto *disk_manager = new DiskManager(db_name);
+    auto *bpm = new ParallelBufferPoolManager(num_instances, total_pool_size / num_instances, disk_manager);
+
+    std::vector<std::vector<page_id_t>> page_ids(num_threads);
+    std::vector<std::thread> threads;
+    for (int tid = 0; tid < num_threads; tid++) {
+      threads.emplace_back([bpm, &page_ids, tid]() {
+        page_id_t page_id;
+        for (int i = 0; i < num_new_pages; i++) {
+          ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+          EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+          page_ids[tid].push_back(page_id);
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    std::set<page_id_t> all_page_ids;
+    std::vector<size_t> instance_pages(num_instances);
+    for (const auto &ids : page_ids) {
+      for (page_id_t page_id : ids) {
+        EXPECT_TRUE(all_page_ids.insert(page_id).second);
+        instance_pages[page_id % num_instances]++;
+      }
+    }
+    EXPECT_EQ(static_cast<size_t>(num_threads * num_new_pages), all_page_ids.size());
+    for (size_t count : instance_pages) {
+      EXPECT_LT(0, count);
+    }
+
+    disk_manager->ShutDown();
+    delete bpm;
+    delete disk_manager;
+    RemoveDbFiles();
+  }
+}
+
+// Prefetch pages that were evicted from a parallel pool and check that they come back intact. Prefetching pages
+// that are resident, or more pages than fit, must not disturb pinned pages.
+// NOLINTNEXTLINE
+TEST_F(ParallelBufferPoolTest, PrefetchTest) {
+  const size_t num_instances = 4;
+  const size_t pool_size = 16;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  NewNumberedPages(bpm, 4 * num_instances * pool_size, &page_ids);
+
+  auto *pinned = bpm->FetchPage(page_ids.back());
+  ASSERT_NE(nullptr, pinned);
+  bpm->PrefetchPages(page_ids);
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    auto *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_ids[i], std::stoi(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  EXPECT_EQ(1, pinned->GetPinCount());
+  EXPECT_TRUE(bpm->UnpinPage(page_ids.back(), false));
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// Counters of a parallel pool add up over its instances.
+// NOLINTNEXTLINE
+TEST_F(ParallelBufferPoolTest, MetricsTest) {
+  const size_t num_instances = 2;
+  const size_t pool_size = 4;
+  const size_t num_frames = num_instances * pool_size;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+
+  // Fill the pool with dirty pages, then fetch them all back: hits.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < 2 * num_frames; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, i < num_frames));
+    page_ids.push_back(page_id);
+    if (i + 1 == num_frames) {
+      for (size_t j = 0; j < num_frames; j++) {
+        ASSERT_NE(nullptr, bpm->FetchPage(page_ids[j]));
+        EXPECT_TRUE(bpm->UnpinPage(page_ids[j], false));
+      }
+    }
+  }
+  // The second half of the new pages evicted the dirty first half. Bring it back: misses, and more evictions.
+  for (size_t i = 0; i < num_frames; i++) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+  }
+  // Every frame is pinned now. NewPage fails on each instance.
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids.back()));
+  page_id_t page_id;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id));
+
+  auto metrics = bpm->GetMetrics();
+  EXPECT_EQ(2 * num_frames + 1, metrics.fetches_);
+  EXPECT_EQ(num_frames, metrics.hits_);
+  EXPECT_EQ(num_frames, metrics.misses_);
+  EXPECT_EQ(2 * num_frames, metrics.evictions_);
+  EXPECT_EQ(num_frames, metrics.foreground_writebacks_);
+  EXPECT_EQ(0, metrics.background_writebacks_);
+  EXPECT_EQ(1 + num_instances, metrics.pin_failures_);
+  EXPECT_DOUBLE_EQ(static_cast<double>(num_frames) / (2 * num_frames + 1), metrics.HitRatio());
+
+  for (size_t i = 0; i < num_frames; i++) {
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// FetchPages hands each instance its share of the batch and puts the pages back in the order of the batch. A batch
+// larger than the pool gets what fits; the rest comes back empty.
+// NOLINTNEXTLINE
+TEST_F(ParallelBufferPoolTest, FetchPagesTest) {
+  const size_t num_instances = 4;
+  const size_t pool_size = 16;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+  std::vector<page_id_t> page_ids;
+  NewNumberedPages(bpm, 4 * num_instances * pool_size, &page_ids);
+  bpm->FlushAllPages();
+
+  // Half a pool's worth of the first pages, backwards, so that the instances take turns out of order.
+  std::vector<page_id_t> batch(page_ids.begin(), page_ids.begin() + num_instances * pool_size / 2);
+  std::reverse(batch.begin(), batch.end());
+  std::vector<Page *> pages(batch.size());
+  bpm->FetchPages(batch.data(), batch.size(), pages.data());
+  for (size_t i = 0; i < batch.size(); i++) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(batch[i], std::stoi(pages[i]->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(batch[i], false));
+  }
+
+  batch.resize(num_instances * pool_size + 1);
+  std::iota(batch.begin(), batch.end(), 0);
+  pages.resize(batch.size());
+  bpm->FetchPages(batch.data(), batch.size(), pages.data());
+  EXPECT_EQ(nullptr, pages.back());
+  for (size_t i = 0; i + 1 < batch.size(); i++) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(batch[i], std::stoi(pages[i]->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(batch[i], false));
+  }
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// Flushing all pages of a parallel pool is a checkpoint: the instances write back their pages, then the db file is
+// synced once.
+// NOLINTNEXTLINE
+TEST_F(ParallelBufferPoolTest, FlushAllSyncTest) {
+  const size_t num_instances = 4;
+  const size_t pool_size = 8;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name, AsyncIoType::AUTO, DurabilityMode::SYNC_ON_CHECKPOINT);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+  for (size_t i = 0; i < num_instances * pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ(0, disk_manager->GetNumSyncs());
+  bpm->FlushAllPages();
+  EXPECT_EQ(num_instances * pool_size, disk_manager->GetNumWrites());
+  EXPECT_EQ(1, disk_manager->GetNumSyncs());
+  // Nothing was written since, so there is nothing to sync.
+  bpm->FlushAllPages();
+  EXPECT_EQ(1, disk_manager->GetNumSyncs());
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// Resizing a parallel pool resizes every instance to the same size, or none of them.
+// NOLINTNEXTLINE
+TEST_F(ParallelBufferPoolTest, ResizeTest) {
+  const size_t num_instances = 4;
+  const size_t pool_size = 8;
+  const size_t max_pool_size = 16;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager, nullptr, ReplacerPolicy::CLOCK,
+                                            HugePageMode::NONE, false, max_pool_size);
+  EXPECT_FALSE(bpm->Resize(0));
+  EXPECT_FALSE(bpm->Resize(max_pool_size + 1));
+  EXPECT_EQ(num_instances * pool_size, bpm->GetPoolSize());
+
+  // Two threads resize to different sizes at the same time. Each call has to leave all instances at its size.
+  std::vector<std::thread> resizers;
+  for (size_t size : {pool_size / 2, max_pool_size}) {
+    resizers.emplace_back([&, size]() {
+      for (int i = 0; i < 100; i++) {
+        EXPECT_TRUE(bpm->Resize(size));
+      }
+    });
+  }
+  for (auto &resizer : resizers) {
+    resizer.join();
+  }
+  size_t total_pool_size = bpm->GetPoolSize();
+  EXPECT_TRUE(total_pool_size == num_instances * pool_size / 2 || total_pool_size == num_instances * max_pool_size);
+
+  std::vector<page_id_t> page_ids;
+  NewNumberedPages(bpm, total_pool_size, &page_ids);
+  for (page_id_t page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id, std::stoi(page->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
 
 }  // namespace bustub
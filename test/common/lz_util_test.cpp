@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz_util_test.cpp
+//
+// Identification: test/common/lz_util_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "common/config.h"
+#include "common/util/lz_util.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+/** Compress and decompress a block, and return the compressed size. */
+size_t RoundTrip(const std::vector<char> &data) {
+  std::vector<char> compressed(data.size() + data.size() / 255 + 16);
+  size_t size = LzUtil::Compress(data.data(), data.size(), compressed.data(), compressed.size());
+  EXPECT_NE(0, size);
+  std::vector<char> decompressed(data.size());
+  EXPECT_TRUE(LzUtil::Decompress(compressed.data(), size, decompressed.data(), decompressed.size()));
+  EXPECT_EQ(data, decompressed);
+  return size;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(LzUtilTest, RoundTripTest) {
+  std::mt19937 gen(0);
+
+  // Zeroes, e.g. the free space of a page, collapse into a single long match.
+  std::vector<char> zeroes(PAGE_SIZE, 0);
+  EXPECT_LT(RoundTrip(zeroes), 32);
+
+  // A column of small increasing integers, the way a table page stores them.
+  std::vector<char> column(PAGE_SIZE, 0);
+  for (size_t i = 0; i + 8 <= column.size(); i += 8) {
+    auto value = static_cast<int32_t>(i / 8 % 10);
+    memcpy(column.data() + i, &value, sizeof(value));
+  }
+  EXPECT_LT(RoundTrip(column), PAGE_SIZE / 4);
+
+  // Random bytes do not compress, but still round trip.
+  std::vector<char> random(PAGE_SIZE);
+  for (auto &byte : random) {
+    byte = static_cast<char>(gen());
+  }
+  RoundTrip(random);
+
+  // Short blocks, including ones too short for any match.
+  for (size_t len = 0; len < 20; len++) {
+    RoundTrip(std::vector<char>(random.begin(), random.begin() + len));
+    RoundTrip(std::vector<char>(len, 'a'));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(LzUtilTest, LimitsTest) {
+  std::mt19937 gen(0);
+  std::vector<char> random(PAGE_SIZE);
+  for (auto &byte : random) {
+    byte = static_cast<char>(gen());
+  }
+  std::vector<char> buffer(PAGE_SIZE);
+  // Does not fit.
+  EXPECT_EQ(0, LzUtil::Compress(random.data(), random.size(), buffer.data(), PAGE_SIZE / 2));
+
+  std::vector<char> zeroes(PAGE_SIZE, 0);
+  size_t size = LzUtil::Compress(zeroes.data(), zeroes.size(), buffer.data(), buffer.size());
+  ASSERT_NE(0, size);
+  std::vector<char> out(PAGE_SIZE);
+  // Wrong lengths and truncated blocks are caught.
+  EXPECT_FALSE(LzUtil::Decompress(buffer.data(), size, out.data(), out.size() - 1));
+  EXPECT_FALSE(LzUtil::Decompress(buffer.data(), size / 2, out.data(), out.size()));
+  // A match reaching before the start of the output is caught.
+  const char bad[] = {0x10, 'x', 0x02, 0x00};
+  EXPECT_FALSE(LzUtil::Decompress(bad, sizeof(bad), out.data(), 5));
+}
+
+}  // namespace bustub
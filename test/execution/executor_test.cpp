@@ -110,6 +110,25 @@ TEST_F(ExecutorTest, DISABLED_SimpleSeqScanTest) {
   }
 }
 
+// SELECT col_a FROM test_1, confined to a ring of 4 frames
+TEST_F(ExecutorTest, BulkReadSeqScanTest) {
+  TableInfo *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  const Schema &schema = table_info->schema_;
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}});
+  SeqScanPlanNode plan{out_schema, nullptr, table_info->oid_};
+
+  GetExecutorContext()->SetScanStrategy(BufferAccessStrategyType::BULK_READ, 4);
+  std::vector<Tuple> result_set{};
+  GetExecutionEngine()->Execute(&plan, &result_set, GetTxn(), GetExecutorContext());
+
+  // The ring changes which frames the scan uses, not what it returns.
+  ASSERT_EQ(result_set.size(), TEST1_SIZE);
+  for (size_t i = 0; i < result_set.size(); i++) {
+    ASSERT_EQ(static_cast<int32_t>(i), result_set[i].GetValue(out_schema, 0).GetAs<int32_t>());
+  }
+}
+
 // INSERT INTO empty_table2 VALUES (100, 10), (101, 11), (102, 12)
 TEST_F(ExecutorTest, DISABLED_SimpleRawInsertTest) {
   // Create Values to insert
@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// db_file_test_util.h
+//
+// Identification: test/include/db_file_test_util.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * The DbFileTest class is a test fixture for tests that keep a database in test.db. Before and after each test it
+ * removes every file of that database: the db file, the log, the free page map, the segment list and the segment
+ * files, so that no test sees what an earlier one left behind.
+ */
+class DbFileTest : public ::testing::Test {
+ protected:
+  void SetUp() override { RemoveDbFiles(); }
+
+  void TearDown() override { RemoveDbFiles(); }
+
+  static void RemoveDbFiles() {
+    for (const char *file_name : {"test.db", "test.log", "test.fsm", "test.seg", "test.seg.tmp"}) {
+      remove(file_name);
+    }
+    for (segment_id_t segment_id = DiskManager::MAIN_SEGMENT + 1; segment_id < DiskManager::MAX_SEGMENTS;
+         segment_id++) {
+      remove(("test.db." + std::to_string(segment_id)).c_str());
+    }
+  }
+
+  /**
+   * Create pages that each hold their page id as a string, and unpin them dirty.
+   * @param bpm the buffer pool to create the pages in
+   * @param num_pages the number of pages to create
+   * @param[out] page_ids the ids of the pages are appended here
+   */
+  static void NewNumberedPages(BufferPoolManager *bpm, size_t num_pages, std::vector<page_id_t> *page_ids) {
+    for (size_t i = 0; i < num_pages; i++) {
+      page_id_t page_id;
+      Page *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+      page_ids->push_back(page_id);
+    }
+  }
+};
+
+}  // namespace bustub
@@ -10,28 +10,21 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <cstdio>
 #include <cstring>
+#include <future>  // NOLINT
+#include <thread>  // NOLINT
+#include <unistd.h>
+#include <vector>
 
 #include "common/exception.h"
+#include "db_file_test_util.h"  // NOLINT
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
-class DiskManagerTest : public ::testing::Test {
- protected:
-  // This function is called before every test.
-  void SetUp() override {
-    remove("test.db");
-    remove("test.log");
-  }
-
-  // This function is called after every test.
-  void TearDown() override {
-    remove("test.db");
-    remove("test.log");
-  };
-};
+class DiskManagerTest : public DbFileTest {};
 
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWritePageTest) {
@@ -55,6 +48,518 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, WritePagesTest) {
+  const size_t num_pages = 3;
+  char buf[PAGE_SIZE] = {0};
+  char data[num_pages][PAGE_SIZE] = {{0}};
+  const char *page_data[num_pages];
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  for (size_t i = 0; i < num_pages; i++) {
+    snprintf(data[i], sizeof(data[i]), "page %zu", i);
+    page_data[i] = data[i];
+  }
+
+  // A run past the end of the file, then one overwriting its middle.
+  dm.WritePages(2, page_data, num_pages);
+  dm.WritePages(3, page_data, 1);
+  EXPECT_EQ(num_pages + 1, dm.GetNumWrites());
+
+  const char *expected[] = {data[0], data[0], data[2]};
+  for (size_t i = 0; i < num_pages; i++) {
+    dm.ReadPage(2 + i, buf);
+    EXPECT_EQ(std::memcmp(buf, expected[i], sizeof(buf)), 0);
+  }
+
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ConcurrentReadWritePageTest) {
+  const std::string db_file("test.db");
+  DiskManager dm(db_file);
+  const int num_threads = 4;
+  const int pages_per_thread = 64;
+
+  // Each thread writes its own pages, interleaved with the other threads, and reads them back.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&dm, tid] {
+      char buf[PAGE_SIZE];
+      char data[PAGE_SIZE];
+      for (int i = 0; i < pages_per_thread; i++) {
+        page_id_t page_id = i * num_threads + tid;
+        memset(data, 'a' + tid, PAGE_SIZE);
+        snprintf(data, PAGE_SIZE, "page %d", page_id);
+        dm.WritePage(page_id, data);
+        dm.ReadPage(page_id, buf);
+        EXPECT_EQ(std::memcmp(buf, data, PAGE_SIZE), 0);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(dm.GetNumWrites(), num_threads * pages_per_thread);
+  EXPECT_EQ(dm.GetDbFileSize(), static_cast<size_t>(num_threads * pages_per_thread * PAGE_SIZE));
+  dm.ShutDown();
+
+  // The tracked size is picked up again when the file is reopened.
+  DiskManager dm2(db_file);
+  EXPECT_EQ(dm2.GetDbFileSize(), static_cast<size_t>(num_threads * pages_per_thread * PAGE_SIZE));
+  char buf[PAGE_SIZE];
+  dm2.ReadPage(num_threads * pages_per_thread, buf);
+  EXPECT_EQ(buf[0], 0);
+  dm2.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, AsyncReadWritePagesTest) {
+  const std::string db_file("test.db");
+  const size_t num_pages = 256;
+  for (auto type : {AsyncIoType::IO_URING, AsyncIoType::THREAD_POOL}) {
+    remove(db_file.c_str());
+    DiskManager dm(db_file, type);
+    if (type == AsyncIoType::THREAD_POOL) {
+      EXPECT_EQ(dm.GetAsyncIoType(), AsyncIoType::THREAD_POOL);
+    }
+
+    // Write every page on its own, all of them in flight together, then read them back in runs of 16.
+    std::vector<char> data(num_pages * PAGE_SIZE);
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < num_pages; i++) {
+      char *page = data.data() + i * PAGE_SIZE;
+      memset(page, static_cast<char>(i), PAGE_SIZE);
+      snprintf(page, PAGE_SIZE, "page %zu", i);
+      const char *page_data = page;
+      futures.push_back(dm.WritePagesAsync(i, &page_data, 1));
+    }
+    for (auto &future : futures) {
+      future.wait();
+    }
+    EXPECT_EQ(dm.GetNumWrites(), static_cast<int>(num_pages));
+    EXPECT_EQ(dm.GetDbFileSize(), num_pages * PAGE_SIZE);
+
+    std::vector<char> buf(num_pages * PAGE_SIZE);
+    std::vector<char *> page_data(num_pages);
+    for (size_t i = 0; i < num_pages; i++) {
+      page_data[i] = buf.data() + i * PAGE_SIZE;
+    }
+    futures.clear();
+    for (size_t i = 0; i < num_pages; i += 16) {
+      futures.push_back(dm.ReadPagesAsync(i, page_data.data() + i, 16));
+    }
+    for (auto &future : futures) {
+      future.wait();
+    }
+    EXPECT_EQ(std::memcmp(buf.data(), data.data(), num_pages * PAGE_SIZE), 0);
+
+    // A run that goes past the end of the file reads as zeroes there.
+    memset(buf.data(), 'x', 2 * PAGE_SIZE);
+    dm.ReadPagesAsync(num_pages - 1, page_data.data(), 2).wait();
+    EXPECT_EQ(std::memcmp(buf.data(), data.data() + (num_pages - 1) * PAGE_SIZE, PAGE_SIZE), 0);
+    EXPECT_EQ(buf[PAGE_SIZE], 0);
+    EXPECT_EQ(buf[2 * PAGE_SIZE - 1], 0);
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DurabilityModeTest) {
+  char data[PAGE_SIZE] = {0};
+  char log_data[2][16] = {{0}};
+  const std::string db_file("test.db");
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  {
+    // Nothing is ever synced.
+    DiskManager dm(db_file, AsyncIoType::AUTO, DurabilityMode::NONE);
+    dm.WritePage(0, data);
+    dm.SyncData();
+    dm.ShutDown();
+    EXPECT_EQ(dm.GetNumSyncs(), 0);
+  }
+  {
+    // Syncs happen on request, and only if something was written since the last one.
+    DiskManager dm(db_file, AsyncIoType::AUTO, DurabilityMode::SYNC_ON_CHECKPOINT);
+    dm.WritePage(0, data);
+    dm.WritePage(1, data);
+    const char *page_data[] = {data, data};
+    dm.WritePagesAsync(2, page_data, 2).wait();
+    EXPECT_EQ(dm.GetNumSyncs(), 0);
+    dm.SyncData();
+    EXPECT_EQ(dm.GetNumSyncs(), 1);
+    dm.SyncData();
+    EXPECT_EQ(dm.GetNumSyncs(), 1);
+    dm.WriteLog(log_data[0], sizeof(log_data[0]));
+    dm.SyncLog();
+    EXPECT_EQ(dm.GetNumSyncs(), 2);
+    dm.WritePage(4, data);
+    dm.ShutDown();
+    EXPECT_EQ(dm.GetNumSyncs(), 3);
+  }
+  {
+    // Every write is synced before it returns.
+    DiskManager dm(db_file, AsyncIoType::AUTO, DurabilityMode::SYNC_EACH_WRITE);
+    dm.WritePage(0, data);
+    EXPECT_EQ(dm.GetNumSyncs(), 1);
+    const char *page_data = data;
+    dm.WritePagesAsync(1, &page_data, 1).wait();
+    EXPECT_EQ(dm.GetNumSyncs(), 2);
+    dm.WriteLog(log_data[0], sizeof(log_data[0]));
+    dm.WriteLog(log_data[1], sizeof(log_data[1]));
+    EXPECT_EQ(dm.GetNumSyncs(), 4);
+    dm.SyncData();
+    dm.ShutDown();
+    EXPECT_EQ(dm.GetNumSyncs(), 4);
+  }
+  for (AsyncIoType async_io_type : {AsyncIoType::IO_URING, AsyncIoType::THREAD_POOL}) {
+    // Whichever backend completes an async write, it is synced once, by the time waiting for it returns.
+    DiskManager dm(db_file, async_io_type, DurabilityMode::SYNC_EACH_WRITE);
+    const char *page_data = data;
+    dm.WritePagesAsync(0, &page_data, 1).wait();
+    EXPECT_EQ(dm.GetNumSyncs(), 1);
+    dm.ShutDown();
+  }
+  {
+    // A write syncs only the file of its segment, a checkpoint all of them.
+    DiskManager dm(db_file, AsyncIoType::AUTO, DurabilityMode::SYNC_EACH_WRITE);
+    segment_id_t segment = dm.CreateSegment();
+    dm.CreateSegment();
+    dm.WritePage(DiskManager::GetFirstPageId(segment), data);
+    EXPECT_EQ(dm.GetNumSyncs(), 1);
+    dm.ShutDown();
+  }
+  {
+    DiskManager dm(db_file, AsyncIoType::AUTO, DurabilityMode::SYNC_ON_CHECKPOINT);
+    dm.WritePage(0, data);
+    dm.SyncData();
+    EXPECT_EQ(dm.GetNumSyncs(), 3);
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, BatchedSyncTest) {
+  const std::string db_file("test.db");
+  DiskManager dm(db_file, AsyncIoType::AUTO, DurabilityMode::SYNC_ON_CHECKPOINT);
+  const int num_threads = 8;
+  const int rounds = 50;
+
+  // Every thread syncs after each of its writes. Threads that find a sync going on share the next one.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; tid++) {
+    threads.emplace_back([&dm, tid] {
+      char data[PAGE_SIZE] = {0};
+      for (int i = 0; i < rounds; i++) {
+        dm.WritePage(i * num_threads + tid, data);
+        dm.SyncData();
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  int num_syncs = dm.GetNumSyncs();
+  EXPECT_GE(num_syncs, rounds);
+  EXPECT_LE(num_syncs, num_threads * rounds);
+  dm.SyncData();
+  EXPECT_EQ(dm.GetNumSyncs(), num_syncs);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreePageMapTest) {
+  char data[PAGE_SIZE] = {0};
+  const std::string db_file("test.db");
+  {
+    DiskManager dm(db_file);
+    dm.WritePage(0, data);
+    for (page_id_t page_id : {3, 6, 7, 10, 5000, 70000}) {
+      dm.DeallocatePage(page_id);
+    }
+    dm.DeallocatePage(6);
+    EXPECT_EQ(dm.GetNumFreePages(), 6);
+
+    // Pages are taken lowest id first, among the ids of the instance and below the limit.
+    EXPECT_EQ(dm.AllocateFreePage(100, 2, 0), 6);
+    EXPECT_EQ(dm.AllocateFreePage(100, 2, 0), 10);
+    EXPECT_EQ(dm.AllocateFreePage(100, 2, 0), INVALID_PAGE_ID);
+    EXPECT_EQ(dm.AllocateFreePage(5, 2, 1), 3);
+    EXPECT_EQ(dm.AllocateFreePage(5, 2, 1), INVALID_PAGE_ID);
+    EXPECT_EQ(dm.AllocateFreePage(10000, 2, 1), 7);
+    dm.ReservePage(5000);
+    EXPECT_EQ(dm.GetNumFreePages(), 1);
+    // A page freed below where the last search of its instance ended is found again.
+    dm.DeallocatePage(1);
+    dm.DeallocatePage(2);
+    EXPECT_EQ(dm.AllocateFreePage(100, 2, 1), 1);
+    EXPECT_EQ(dm.AllocateFreePage(100, 2, 0), 2);
+    EXPECT_EQ(dm.AllocateFreePage(100, 2, 0), INVALID_PAGE_ID);
+    EXPECT_EQ(dm.GetNumFreePages(), 1);
+    dm.ShutDown();
+  }
+  {
+    // The map is written back on shutdown and read again when the file is reopened.
+    DiskManager dm(db_file);
+    EXPECT_EQ(dm.GetNumFreePages(), 1);
+    EXPECT_EQ(dm.AllocateFreePage(100000, 1, 0), 70000);
+    dm.ShutDown();
+  }
+  remove(db_file.c_str());
+  {
+    DiskManager dm(db_file);
+    dm.DeallocatePage(1);
+    dm.ShutDown();
+  }
+  remove(db_file.c_str());
+  {
+    // A new db file starts with an empty map.
+    DiskManager dm(db_file);
+    EXPECT_EQ(dm.GetNumFreePages(), 0);
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreePageMapCrashTest) {
+  char data[PAGE_SIZE] = {0};
+  const std::string db_file("test.db");
+  DiskManager dm(db_file, AsyncIoType::AUTO, DurabilityMode::SYNC_ON_CHECKPOINT);
+  dm.WritePage(0, data);
+  for (page_id_t page_id : {3, 4}) {
+    dm.DeallocatePage(page_id);
+  }
+  dm.SyncData();
+  EXPECT_EQ(dm.AllocateFreePage(100, 1, 0), 3);
+  dm.DeallocatePage(5);
+
+  // Reopen without a shutdown or a checkpoint, as after a crash. The reused page is not free any more; the free that
+  // was not checkpointed is lost, which only leaks its page.
+  DiskManager reopened(db_file);
+  EXPECT_EQ(reopened.GetNumFreePages(), 1);
+  EXPECT_EQ(reopened.AllocateFreePage(100, 1, 0), 4);
+  EXPECT_EQ(reopened.AllocateFreePage(100, 1, 0), INVALID_PAGE_ID);
+  reopened.ShutDown();
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ExtentTest) {
+  const std::string db_file("test.db");
+  DiskManager dm(db_file);
+  for (page_id_t page_id = 0; page_id < 5; page_id++) {
+    EXPECT_TRUE(dm.ReservePage(page_id));
+  }
+  // Extents start above every id handed out so far, at a multiple of their size.
+  EXPECT_EQ(dm.AllocateExtent(16), 16);
+  EXPECT_EQ(dm.AllocateExtent(16), 32);
+  EXPECT_EQ(dm.AllocateExtent(4), 48);
+  // Ids in extents are refused, the ones in between are not.
+  for (page_id_t page_id = 5; page_id < 60; page_id++) {
+    EXPECT_EQ(dm.ReservePage(page_id), page_id < 16 || page_id >= 52) << page_id;
+  }
+  EXPECT_EQ(dm.AllocateExtent(8), 64);
+
+  // Deleted pages in the range of an extent are not handed out twice.
+  dm.DeallocatePage(100);
+  EXPECT_EQ(dm.AllocateExtent(32), 96);
+  EXPECT_EQ(dm.GetNumFreePages(), 0);
+
+  // The main segment ends where the ids of the first segment file begin.
+  const auto max_pages = static_cast<page_id_t>(DiskManager::SEGMENT_MAX_PAGES);
+  EXPECT_THROW(dm.ReservePage(max_pages), Exception);
+  EXPECT_EQ(dm.AllocateExtent(DiskManager::SEGMENT_MAX_PAGES / 2), max_pages / 2);
+  EXPECT_THROW(dm.AllocateExtent(DiskManager::SEGMENT_MAX_PAGES / 2), Exception);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, MmapReadOnlyTest) {
+  const std::string db_file("test.db");
+  const size_t num_pages = 8;
+  EXPECT_THROW(DiskManager(db_file, AsyncIoType::AUTO, DurabilityMode::NONE, DiskIoMode::MMAP_READ_ONLY), Exception);
+  remove("test.fsm");
+
+  char data[PAGE_SIZE];
+  char buf[PAGE_SIZE];
+  {
+    DiskManager dm(db_file);
+    for (size_t i = 0; i < num_pages; i++) {
+      memset(data, static_cast<int>('a' + i), PAGE_SIZE);
+      dm.WritePage(i, data);
+    }
+    dm.ShutDown();
+  }
+
+  DiskManager dm(db_file, AsyncIoType::AUTO, DurabilityMode::NONE, DiskIoMode::MMAP_READ_ONLY);
+  EXPECT_EQ(DiskIoMode::MMAP_READ_ONLY, dm.GetIoMode());
+  dm.AdviseAccess(AccessPattern::SEQUENTIAL);
+  dm.AdviseWillNeed(0, num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    const char *mapped = dm.GetMappedPage(i);
+    ASSERT_NE(nullptr, mapped);
+    EXPECT_EQ(static_cast<char>('a' + i), mapped[PAGE_SIZE - 1]);
+    dm.ReadPage(i, buf);
+    EXPECT_EQ(0, memcmp(buf, mapped, PAGE_SIZE));
+  }
+  EXPECT_EQ(nullptr, dm.GetMappedPage(num_pages));
+
+  // Runs are copied out of the mapping, zero-filled past the end of the file.
+  std::vector<char> run(3 * PAGE_SIZE);
+  char *run_data[] = {run.data(), run.data() + PAGE_SIZE, run.data() + 2 * PAGE_SIZE};
+  dm.ReadPagesAsync(num_pages - 2, run_data, 3).get();
+  EXPECT_EQ(0, memcmp(run_data[0], dm.GetMappedPage(num_pages - 2), PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(run_data[1], dm.GetMappedPage(num_pages - 1), PAGE_SIZE));
+  EXPECT_EQ(0, run_data[2][0]);
+
+  // Writes are dropped.
+  memset(data, 'z', PAGE_SIZE);
+  dm.WritePage(0, data);
+  dm.WritePagesAsync(1, run_data, 1).get();
+  EXPECT_EQ('a', dm.GetMappedPage(0)[0]);
+  EXPECT_EQ('b', dm.GetMappedPage(1)[0]);
+  EXPECT_EQ(num_pages * PAGE_SIZE, dm.GetDbFileSize());
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIoTest) {
+  const std::string db_file("test.db");
+  const size_t num_pages = 4;
+  DiskManager dm(db_file, AsyncIoType::AUTO, DurabilityMode::NONE, DiskIoMode::DIRECT);
+  // tmpfs and some other file systems do not do direct I/O; the disk manager then falls back to buffered I/O.
+  EXPECT_NE(DiskIoMode::MMAP_READ_ONLY, dm.GetIoMode());
+
+  // Aligned buffers are used as they are, others go through aligned copies.
+  AlignedPageBuffer aligned(num_pages);
+  std::vector<char> unaligned_buffer((num_pages + 1) * PAGE_SIZE);
+  char *unaligned = unaligned_buffer.data() + 1;
+  for (size_t i = 0; i < num_pages; i++) {
+    memset(aligned.GetPage(i), static_cast<int>('a' + i), PAGE_SIZE);
+  }
+  dm.WritePage(0, aligned.GetPage(0));
+  memcpy(unaligned, aligned.GetPage(1), PAGE_SIZE);
+  dm.WritePage(1, unaligned);
+  const char *run[] = {aligned.GetPage(2), unaligned};
+  memcpy(unaligned, aligned.GetPage(3), PAGE_SIZE);
+  dm.WritePagesAsync(2, run, 2).get();
+
+  for (size_t i = 0; i < num_pages; i++) {
+    memset(unaligned, 0, PAGE_SIZE);
+    dm.ReadPage(i, unaligned);
+    EXPECT_EQ(0, memcmp(unaligned, aligned.GetPage(i), PAGE_SIZE));
+  }
+  AlignedPageBuffer read_back(num_pages + 1);
+  char *read_data[] = {read_back.GetPage(0), read_back.GetPage(1), read_back.GetPage(2), read_back.GetPage(3),
+                       unaligned};
+  dm.ReadPagesAsync(0, read_data, num_pages + 1).get();
+  for (size_t i = 0; i < num_pages; i++) {
+    EXPECT_EQ(0, memcmp(read_data[i], aligned.GetPage(i), PAGE_SIZE));
+  }
+  // Past the end of the file.
+  EXPECT_EQ(0, unaligned[0]);
+  EXPECT_EQ(num_pages * PAGE_SIZE, dm.GetDbFileSize());
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, SegmentTest) {
+  const std::string db_file("test.db");
+  char data[PAGE_SIZE];
+  char buf[PAGE_SIZE];
+  segment_id_t table;
+  segment_id_t index;
+  page_id_t first_page_id;
+  {
+    DiskManager dm(db_file);
+    table = dm.CreateSegment();
+    index = dm.CreateSegment();
+    EXPECT_EQ(1, table);
+    EXPECT_EQ(2, index);
+    EXPECT_EQ(0, access("test.db.1", F_OK));
+    EXPECT_EQ(0, access("test.seg", F_OK));
+
+    // The extents of a segment are numbered from the start of its file.
+    first_page_id = dm.AllocateExtent(4, table);
+    EXPECT_EQ(DiskManager::GetFirstPageId(table), first_page_id);
+    EXPECT_EQ(table, DiskManager::GetSegmentId(first_page_id));
+    EXPECT_EQ(first_page_id + 4, dm.AllocateExtent(4, table));
+    EXPECT_EQ(DiskManager::GetFirstPageId(index), dm.AllocateExtent(4, index));
+    EXPECT_EQ(0, dm.AllocateExtent(4));
+
+    memset(data, 't', PAGE_SIZE);
+    dm.WritePage(first_page_id + 1, data);
+    memset(data, 'i', PAGE_SIZE);
+    const char *write_data[] = {data};
+    dm.WritePagesAsync(DiskManager::GetFirstPageId(index), write_data, 1).get();
+    EXPECT_EQ(2 * PAGE_SIZE, dm.GetSegmentFileSize(table));
+    EXPECT_EQ(PAGE_SIZE, dm.GetSegmentFileSize(index));
+    EXPECT_EQ(0, dm.GetDbFileSize());
+    dm.ReadPage(first_page_id + 1, buf);
+    EXPECT_EQ('t', buf[0]);
+
+    // A run across two segments reads each part from its own file.
+    std::vector<char> run(2 * PAGE_SIZE, 'x');
+    char *run_data[] = {run.data(), run.data() + PAGE_SIZE};
+    dm.ReadPagesAsync(DiskManager::GetFirstPageId(index) - 1, run_data, 2).get();
+    EXPECT_EQ(0, run_data[0][0]);
+    EXPECT_EQ('i', run_data[1][0]);
+
+    // Truncating a segment starts its page numbers over.
+    dm.TruncateSegment(table);
+    EXPECT_EQ(0, dm.GetSegmentFileSize(table));
+    dm.ReadPage(first_page_id + 1, buf);
+    EXPECT_EQ(0, buf[0]);
+    EXPECT_EQ(first_page_id, dm.AllocateExtent(4, table));
+    memset(data, 'T', PAGE_SIZE);
+    dm.WritePage(first_page_id, data);
+
+    // Dropping a segment removes its file. Its pages read as zeros, and writing one would lose it.
+    dm.DropSegment(index);
+    EXPECT_NE(0, access("test.db.2", F_OK));
+    EXPECT_EQ(0, dm.GetSegmentFileSize(index));
+    EXPECT_THROW(dm.WritePage(DiskManager::GetFirstPageId(index), data), Exception);
+    EXPECT_THROW(dm.WritePages(DiskManager::GetFirstPageId(index), write_data, 1), Exception);
+    dm.ReadPage(DiskManager::GetFirstPageId(index), buf);
+    EXPECT_EQ(0, buf[0]);
+    EXPECT_THROW(dm.AllocateExtent(4, index), Exception);
+    // Segment ids are not reused.
+    EXPECT_EQ(3, dm.CreateSegment());
+    dm.ShutDown();
+  }
+  {
+    // The segments are found again, and their extents continue after the pages that are in the files.
+    DiskManager dm(db_file);
+    EXPECT_EQ(PAGE_SIZE, dm.GetSegmentFileSize(table));
+    dm.ReadPage(first_page_id, buf);
+    EXPECT_EQ('T', buf[0]);
+    EXPECT_EQ(first_page_id + 4, dm.AllocateExtent(4, table));
+    EXPECT_EQ(4, dm.CreateSegment());
+    dm.ShutDown();
+  }
+  // A file named like a segment that is not on the list is not one.
+  std::fclose(std::fopen("test.db.5", "w"));
+  {
+    DiskManager dm(db_file);
+    EXPECT_EQ(0, dm.GetSegmentFileSize(5));
+    EXPECT_EQ(6, dm.CreateSegment());
+    dm.DropSegment(6);
+    dm.ShutDown();
+  }
+  remove(db_file.c_str());
+  {
+    // A new db file does not pick up the segments of an older one, and leaves the files that were not on its list.
+    DiskManager dm(db_file);
+    EXPECT_NE(0, access("test.db.1", F_OK));
+    EXPECT_NE(0, access("test.db.4", F_OK));
+    EXPECT_EQ(0, access("test.db.5", F_OK));
+    EXPECT_EQ(1, dm.CreateSegment());
+    dm.ShutDown();
+  }
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ReadWriteLogTest) {
   char buf[16] = {0};
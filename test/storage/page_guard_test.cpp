@@ -0,0 +1,194 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "db_file_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+class PageGuardTest : public DbFileTest {};
+
+// NOLINTNEXTLINE
+TEST_F(PageGuardTest, SampleTest) {
+  const size_t pool_size = 5;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+
+  {
+    auto guard = bpm->FetchPageBasic(page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_id, guard.PageId());
+    EXPECT_EQ(1, page->GetPinCount());
+
+    // Moving hands the pin over; the moved-from guard releases nothing.
+    BasicPageGuard moved(std::move(guard));
+    EXPECT_FALSE(guard.IsValid());  // NOLINT
+    EXPECT_EQ(1, page->GetPinCount());
+
+    // Assigning over a guard releases the pin it held.
+    auto other = bpm->FetchPageBasic(page_id);
+    EXPECT_EQ(2, page->GetPinCount());
+    moved = std::move(other);
+    EXPECT_EQ(1, page->GetPinCount());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  // Dropping twice unpins once.
+  auto guard = bpm->FetchPageBasic(page_id);
+  guard.Drop();
+  guard.Drop();
+  EXPECT_EQ(0, page->GetPinCount());
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST_F(PageGuardTest, LatchTest) {
+  const size_t pool_size = 5;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+
+  {
+    auto read_guard = bpm->FetchPageRead(page_id);
+    auto other_read_guard = bpm->FetchPageRead(page_id);
+    EXPECT_TRUE(read_guard.IsValid());
+    EXPECT_TRUE(other_read_guard.IsValid());
+  }
+  {
+    // Both read latches were released, or this would block.
+    auto write_guard = bpm->FetchPageWrite(page_id);
+    auto upgraded = bpm->FetchPageBasic(page_id);
+    write_guard.Drop();
+    auto read_guard = upgraded.UpgradeRead();
+    EXPECT_FALSE(upgraded.IsValid());  // NOLINT
+    EXPECT_TRUE(read_guard.IsValid());
+  }
+  auto write_guard = bpm->FetchPageWrite(page_id);
+  EXPECT_TRUE(write_guard.IsValid());
+  write_guard.Drop();
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// Pages modified through a guard are written back when they are evicted, pages only read are not.
+// NOLINTNEXTLINE
+TEST_F(PageGuardTest, DirtyTest) {
+  const size_t num_instances = 2;
+  const size_t pool_size = 2;
+  const std::string db_name = "test.db";
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, pool_size, disk_manager);
+
+  page_id_t page_ids[2];
+  for (auto &page_id : page_ids) {
+    auto guard = bpm->NewPageGuarded(&page_id).UpgradeWrite();
+    ASSERT_TRUE(guard.IsValid());
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "%d", page_id);
+  }
+  {
+    // Scribble on a clean page without marking it dirty; the change must not reach the disk.
+    EXPECT_TRUE(bpm->FlushPage(page_ids[1]));
+    auto guard = bpm->FetchPageRead(page_ids[1]);
+    snprintf(guard.AsPage<Page>()->GetData(), PAGE_SIZE, "scribble");
+  }
+
+  // Fill both instances with new pages to evict the two pages above.
+  for (size_t i = 0; i < num_instances * pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_TRUE(bpm->NewPageGuarded(&page_id).IsValid());
+  }
+
+  auto guard = bpm->FetchPageRead(page_ids[0]);
+  ASSERT_TRUE(guard.IsValid());
+  EXPECT_EQ(page_ids[0], std::stoi(guard.GetData()));
+  guard = bpm->FetchPageRead(page_ids[1]);
+  ASSERT_TRUE(guard.IsValid());
+  EXPECT_EQ(page_ids[1], std::stoi(guard.GetData()));
+  guard.Drop();
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+// In MMAP_READ_ONLY mode, writing through a guard copies a mapped page into its frame instead of writing to the
+// mapping, whether the guard holds the write latch or no latch at all.
+// NOLINTNEXTLINE
+TEST_F(PageGuardTest, MappedPageTest) {
+  const size_t pool_size = 4;
+  const std::string db_name = "test.db";
+  {
+    DiskManager disk_manager(db_name);
+    char data[PAGE_SIZE];
+    for (page_id_t page_id = 0; page_id < 2; page_id++) {
+      snprintf(data, PAGE_SIZE, "%d", page_id);
+      disk_manager.WritePage(page_id, data);
+    }
+    disk_manager.ShutDown();
+  }
+
+  auto *disk_manager = new DiskManager(db_name, AsyncIoType::AUTO, DurabilityMode::NONE, DiskIoMode::MMAP_READ_ONLY);
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  {
+    auto guard = bpm->FetchPageBasic(0);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(disk_manager->GetMappedPage(0), guard.GetData());
+    char *data = guard.GetDataMut();
+    EXPECT_NE(disk_manager->GetMappedPage(0), data);
+    EXPECT_EQ(0, std::stoi(data));
+    snprintf(data, PAGE_SIZE, "%d", 10);
+  }
+  {
+    auto guard = bpm->FetchPageWrite(1);
+    ASSERT_TRUE(guard.IsValid());
+    snprintf(guard.GetDataMut(), PAGE_SIZE, "%d", 11);
+  }
+  EXPECT_EQ(0, std::stoi(disk_manager->GetMappedPage(0)));
+  EXPECT_EQ(1, std::stoi(disk_manager->GetMappedPage(1)));
+  for (page_id_t page_id = 0; page_id < 2; page_id++) {
+    auto guard = bpm->FetchPageRead(page_id);
+    ASSERT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_id + 10, std::stoi(guard.GetData()));
+  }
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,174 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// simulated_disk_manager_test.cpp
+//
+// Identification: test/storage/simulated_disk_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstring>
+#include <future>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "db_file_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+#include "storage/disk/simulated_disk_manager.h"
+
+namespace bustub {
+
+class SimulatedDiskManagerTest : public DbFileTest {};
+
+// NOLINTNEXTLINE
+TEST_F(SimulatedDiskManagerTest, CounterTest) {
+  SimulatedDiskConfig config;
+  config.read_latency_ = config.write_latency_ = std::chrono::nanoseconds(0);
+  SimulatedDiskManager dm("test.db", config);
+  std::vector<char> pages(4 * PAGE_SIZE);
+  char *page_data[] = {pages.data(), pages.data() + PAGE_SIZE, pages.data() + 2 * PAGE_SIZE,
+                       pages.data() + 3 * PAGE_SIZE};
+  for (size_t i = 0; i < 4; i++) {
+    memset(page_data[i], static_cast<int>('a' + i), PAGE_SIZE);
+  }
+
+  // The pages still go to the db file.
+  dm.WritePage(0, page_data[0]);
+  dm.WritePages(1, page_data + 1, 2);
+  dm.WritePagesAsync(3, page_data + 3, 1).get();
+  memset(pages.data(), 0, pages.size());
+  dm.ReadPage(3, page_data[3]);
+  dm.ReadPages(0, page_data, 2);
+  dm.ReadPagesAsync(2, page_data + 2, 1).get();
+  for (size_t i = 0; i < 4; i++) {
+    EXPECT_EQ(static_cast<char>('a' + i), page_data[i][PAGE_SIZE - 1]);
+  }
+  EXPECT_EQ(4 * PAGE_SIZE, dm.GetDbFileSize());
+  EXPECT_EQ(4, dm.GetNumWrites());
+
+  DiskIoCounters counters = dm.GetIoCounters();
+  EXPECT_EQ(3, counters.writes_);
+  EXPECT_EQ(4, counters.pages_written_);
+  EXPECT_EQ(1, counters.async_writes_);
+  EXPECT_EQ(3, counters.reads_);
+  EXPECT_EQ(4, counters.pages_read_);
+  EXPECT_EQ(1, counters.async_reads_);
+
+  dm.ResetIoCounters();
+  EXPECT_EQ(0, dm.GetIoCounters().reads_);
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(SimulatedDiskManagerTest, LatencyTest) {
+  using std::chrono::milliseconds;
+  const size_t num_reads = 4;
+  SimulatedDiskConfig config;
+  config.read_latency_ = milliseconds(5);
+  config.queue_depth_ = num_reads;
+  SimulatedDiskManager dm("test.db", config);
+  std::vector<char> pages(num_reads * PAGE_SIZE);
+
+  // Synchronous reads are done one after the other.
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_reads; i++) {
+    dm.ReadPage(i, pages.data() + i * PAGE_SIZE);
+  }
+  EXPECT_GE(std::chrono::steady_clock::now() - start, num_reads * config.read_latency_);
+
+  // Asynchronous ones are in flight together, as long as the queue takes them. Only the time they waited for a slot
+  // is counted as queued, so the second round queues behind the first one.
+  std::vector<std::future<void>> reads;
+  for (size_t round = 0; round < 2; round++) {
+    for (size_t i = 0; i < num_reads; i++) {
+      char *page_data = pages.data() + i * PAGE_SIZE;
+      reads.push_back(dm.ReadPagesAsync(i, &page_data, 1));
+    }
+  }
+  start = std::chrono::steady_clock::now();
+  for (auto &read : reads) {
+    read.wait();
+  }
+  EXPECT_GE(std::chrono::steady_clock::now() - start + milliseconds(1), 2 * config.read_latency_);
+  DiskIoCounters counters = dm.GetIoCounters();
+  EXPECT_GE(counters.queued_ns_, num_reads * std::chrono::nanoseconds(milliseconds(4)).count());
+  EXPECT_GE(counters.service_ns_, 3 * num_reads * std::chrono::nanoseconds(config.read_latency_).count());
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(SimulatedDiskManagerTest, BandwidthTest) {
+  const size_t num_pages = 16;
+  SimulatedDiskConfig config;
+  config.read_latency_ = config.write_latency_ = std::chrono::nanoseconds(0);
+  // A page per millisecond, whether the pages come in one request or in many.
+  config.bandwidth_ = PAGE_SIZE * 1000;
+  SimulatedDiskManager dm("test.db", config);
+  std::vector<char> pages(num_pages * PAGE_SIZE);
+  std::vector<char *> page_data(num_pages);
+  for (size_t i = 0; i < num_pages; i++) {
+    page_data[i] = pages.data() + i * PAGE_SIZE;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  dm.ReadPages(0, page_data.data(), num_pages);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(num_pages));
+
+  std::vector<std::future<void>> reads;
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_pages; i++) {
+    reads.push_back(dm.ReadPagesAsync(i, &page_data[i], 1));
+  }
+  for (auto &read : reads) {
+    read.wait();
+  }
+  EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(num_pages));
+  dm.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(SimulatedDiskManagerTest, BufferPoolTest) {
+  const size_t num_pages = 32;
+  SimulatedDiskConfig config;
+  config.read_latency_ = config.write_latency_ = std::chrono::microseconds(10);
+  auto *disk_manager = new SimulatedDiskManager("test.db", config);
+  auto *bpm = new BufferPoolManagerInstance(num_pages, disk_manager);
+  std::vector<page_id_t> page_ids(num_pages);
+  for (auto &page_id : page_ids) {
+    Page *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), PAGE_SIZE, "%d", page_id);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // The write-back goes to the device in runs.
+  bpm->FlushAllPages();
+  DiskIoCounters counters = disk_manager->GetIoCounters();
+  EXPECT_EQ(num_pages, counters.pages_written_);
+  EXPECT_LT(counters.writes_, num_pages);
+  delete bpm;
+
+  // Reading the pages with FetchPages takes fewer requests than one FetchPage each.
+  bpm = new BufferPoolManagerInstance(num_pages, disk_manager);
+  disk_manager->ResetIoCounters();
+  std::vector<Page *> pages(num_pages);
+  bpm->FetchPages(page_ids.data(), num_pages, pages.data());
+  for (size_t i = 0; i < num_pages; i++) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(page_ids[i], std::stoi(pages[i]->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  counters = disk_manager->GetIoCounters();
+  EXPECT_EQ(num_pages, counters.pages_read_);
+  EXPECT_LT(counters.reads_, num_pages);
+
+  disk_manager->ShutDown();
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,126 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_iterator_test.cpp
+//
+// Identification: test/table/table_iterator_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "concurrency/transaction.h"
+#include "db_file_test_util.h"  // NOLINT
+#include "gtest/gtest.h"
+#include "storage/disk/simulated_disk_manager.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+class TableIteratorTest : public DbFileTest {
+ protected:
+  /** Insert tuples numbered first_id and up, each about a quarter of a page. */
+  static void InsertTuples(TableHeap *table, const Schema &schema, Transaction *txn, int32_t first_id,
+                           size_t num_tuples) {
+    const std::string payload(1000, 'x');
+    for (size_t i = 0; i < num_tuples; i++) {
+      std::vector<Value> values{ValueFactory::GetIntegerValue(first_id + static_cast<int32_t>(i)),
+                                ValueFactory::GetVarcharValue(payload)};
+      RID rid;
+      ASSERT_TRUE(table->InsertTuple(Tuple(values, &schema), &rid, txn));
+    }
+  }
+
+  /** Scan the table and check that it holds the tuples numbered 0 to num_tuples - 1, in order. */
+  static void CheckScan(TableHeap *table, const Schema &schema, Transaction *txn, size_t num_tuples) {
+    size_t num_scanned = 0;
+    for (auto it = table->Begin(txn); it != table->End(); ++it) {
+      ASSERT_EQ(static_cast<int32_t>(num_scanned), it->GetValue(&schema, 0).GetAs<int32_t>());
+      num_scanned++;
+    }
+    EXPECT_EQ(num_tuples, num_scanned);
+  }
+};
+
+// Read-ahead prefetches the pages of the heap's extents by id, so the reads of several pages are in flight while the
+// scan works on earlier ones, instead of one after the other.
+// NOLINTNEXTLINE
+TEST_F(TableIteratorTest, ReadAheadTest) {
+  const size_t pool_size = 16;
+  const size_t num_tuples = 200;
+  Schema schema({Column("id", TypeId::INTEGER), Column("payload", TypeId::VARCHAR, 1000)});
+  Transaction txn(0);
+  page_id_t first_page_id;
+  {
+    DiskManager disk_manager("test.db");
+    BufferPoolManagerInstance bpm(pool_size, &disk_manager);
+    TableHeap table(&bpm, nullptr, nullptr, &txn);
+    InsertTuples(&table, schema, &txn, 0, num_tuples);
+    first_page_id = table.GetFirstPageId();
+    bpm.FlushAllPages();
+    disk_manager.ShutDown();
+  }
+
+  SimulatedDiskConfig config;
+  config.read_latency_ = std::chrono::milliseconds(1);
+  auto *disk_manager = new SimulatedDiskManager("test.db", config);
+
+  // Scan the table from a cold pool, without and with read-ahead.
+  std::chrono::steady_clock::duration elapsed[2];
+  for (size_t read_ahead : {0, 1}) {
+    auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+    auto *table = new TableHeap(bpm, nullptr, nullptr, first_page_id);
+    table->SetReadAheadPages(read_ahead * TableHeap::DEFAULT_READ_AHEAD_PAGES);
+    auto start = std::chrono::steady_clock::now();
+    CheckScan(table, schema, &txn, num_tuples);
+    elapsed[read_ahead] = std::chrono::steady_clock::now() - start;
+    delete table;
+    delete bpm;
+  }
+  // Without read-ahead, each page is read after the scan got to it.
+  EXPECT_LT(2 * elapsed[1], elapsed[0]);
+
+  disk_manager->ShutDown();
+  delete disk_manager;
+}
+
+// Read-ahead past the last page of the heap reads pages that do not exist yet. When the heap grows into them, the new
+// pages take over their frames.
+// NOLINTNEXTLINE
+TEST_F(TableIteratorTest, ReadAheadPastEndTest) {
+  const size_t pool_size = 32;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  Schema schema({Column("id", TypeId::INTEGER), Column("payload", TypeId::VARCHAR, 1000)});
+  Transaction txn(0);
+  auto *table = new TableHeap(bpm, nullptr, nullptr, &txn);
+  size_t num_tuples = 0;
+  for (size_t round = 0; round < 8; round++) {
+    InsertTuples(table, schema, &txn, static_cast<int32_t>(num_tuples), 5);
+    num_tuples += 5;
+    CheckScan(table, schema, &txn, num_tuples);
+  }
+
+  // The pages come back from disk as they were written.
+  bpm->FlushAllPages();
+  delete bpm;
+  bpm = new BufferPoolManagerInstance(pool_size, disk_manager);
+  auto *reopened_table = new TableHeap(bpm, nullptr, nullptr, table->GetFirstPageId());
+  CheckScan(reopened_table, schema, &txn, num_tuples);
+
+  disk_manager->ShutDown();
+  delete reopened_table;
+  delete table;
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub